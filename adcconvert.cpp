@@ -0,0 +1,110 @@
+#include "adcconvert.h"
+
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define ADCCONVERT_SSE2 1
+#endif
+
+double sensitivityAt(double tared, const Calibration &calibration)
+{
+    const CalibrationCurve &curve = calibration.curve;
+    switch (curve.kind) {
+    case CalibrationCurve::Polynomial:
+        return curve.c[1] + 2.0 * curve.c[2] * tared;
+    case CalibrationCurve::Piecewise: {
+        // Slope of the segment containing the value
+        size_t i = 0;
+        while (i + 1 < curve.slope.size() && curve.x[i + 1] <= tared)
+            ++i;
+        return curve.slope[i];
+    }
+    case CalibrationCurve::Scale:
+        break;
+    }
+    return 1.0 / calibration.scalingFactor;
+}
+
+double zeroTared(const Calibration &calibration)
+{
+    const CalibrationCurve &curve = calibration.curve;
+    switch (curve.kind) {
+    case CalibrationCurve::Polynomial: {
+        const double c0 = curve.c[0], c1 = curve.c[1], c2 = curve.c[2];
+        if (c2 == 0.0)
+            return c1 != 0.0 ? -c0 / c1 : 0.0;
+        const double disc = c1 * c1 - 4.0 * c2 * c0;
+        if (disc < 0.0)
+            return -c1 / (2.0 * c2);
+        // Stable form of the two roots
+        const double q = -0.5 * (c1 + std::copysign(std::sqrt(disc), c1));
+        const double r1 = q / c2;
+        const double r2 = q != 0.0 ? c0 / q : r1;
+        return std::fabs(r1) < std::fabs(r2) ? r1 : r2;
+    }
+    case CalibrationCurve::Piecewise: {
+        // Segment crossing 0, else the end segment closer to it, extended
+        const size_t n = curve.slope.size();
+        for (size_t i = 0; i < n; ++i) {
+            if ((curve.y[i] <= 0.0) != (curve.y[i + 1] <= 0.0) && curve.slope[i] != 0.0)
+                return curve.x[i] - curve.y[i] / curve.slope[i];
+        }
+        size_t i = std::fabs(curve.y.front()) <= std::fabs(curve.y.back()) ? 0 : n - 1;
+        return curve.slope[i] != 0.0 ? curve.x[i] - curve.y[i] / curve.slope[i] : curve.x[i];
+    }
+    case CalibrationCurve::Scale:
+        break;
+    }
+    return 0.0;
+}
+
+void convertBatch(const uint32_t *codes, size_t n, const Calibration &calibration,
+                  int64_t *tared, double *scaled)
+{
+    size_t i = 0;
+    const CalibrationCurve &curve = calibration.curve;
+
+#ifdef ADCCONVERT_SSE2
+    // double -> int64 without AVX-512: adding 1.5 * 2^52 puts the integer in
+    // the low mantissa bits, exact for |x| < 2^51
+    const __m128d magic = _mm_set1_pd(6755399441055744.0);
+    const __m128i magicBits = _mm_castpd_si128(magic);
+    const __m128d k1000 = _mm_set1_pd(1000.0);
+    const __m128d tare = _mm_set1_pd(double(calibration.tareValue));
+    const __m128d scale = _mm_set1_pd(double(calibration.scalingFactor));
+    const __m128d c0 = _mm_set1_pd(curve.c[0]);
+    const __m128d c1 = _mm_set1_pd(curve.c[1]);
+    const __m128d c2 = _mm_set1_pd(curve.c[2]);
+
+    // Piecewise curves take the scalar path below
+    for (; curve.kind != CalibrationCurve::Piecewise && i + 4 <= n; i += 4) {
+        __m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i *>(codes + i));
+        __m128i code = _mm_srai_epi32(_mm_slli_epi32(raw, 8), 8);
+
+        __m128d lo = _mm_sub_pd(_mm_mul_pd(_mm_cvtepi32_pd(code), k1000), tare);
+        __m128d hi = _mm_sub_pd(_mm_mul_pd(_mm_cvtepi32_pd(_mm_srli_si128(code, 8)), k1000), tare);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(tared + i),
+                         _mm_sub_epi64(_mm_castpd_si128(_mm_add_pd(lo, magic)), magicBits));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(tared + i + 2),
+                         _mm_sub_epi64(_mm_castpd_si128(_mm_add_pd(hi, magic)), magicBits));
+
+        if (curve.kind == CalibrationCurve::Polynomial) {
+            // Horner: (c2 t + c1) t + c0, as in scaledValue()
+            _mm_storeu_pd(scaled + i, _mm_add_pd(_mm_mul_pd(_mm_add_pd(_mm_mul_pd(c2, lo), c1), lo), c0));
+            _mm_storeu_pd(scaled + i + 2, _mm_add_pd(_mm_mul_pd(_mm_add_pd(_mm_mul_pd(c2, hi), c1), hi), c0));
+        }
+        else {
+            _mm_storeu_pd(scaled + i, _mm_div_pd(lo, scale));
+            _mm_storeu_pd(scaled + i + 2, _mm_div_pd(hi, scale));
+        }
+    }
+#endif
+
+    for (; i < n; ++i) {
+        ConvertedSample c = convertSample(codes[i], calibration);
+        tared[i] = c.tared;
+        scaled[i] = c.grams;
+    }
+}
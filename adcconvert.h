@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "calibration.h"
+
+// The NAU7802 delivers a two's complement 24-bit code. Values are shown
+// multiplied by 1000, which is the unit of tareValue and scalingFactor:
+//   tared  = code * 1000 - tareValue
+//   scaled = tared / scalingFactor, or the multi-point curve at tared
+// With the tare within kTareLimit, tared is exact in int64 and both fit a
+// double exactly (|tared| < 2^35, far below the kernel's 2^51 limit),
+// and the kernel evaluates the curve with the same operations in the same
+// order, so the batch kernel and convertSample() give bit-identical results.
+
+struct ConvertedSample
+{
+    int64_t extracted;
+    int64_t tared;
+    double grams;
+};
+
+inline int32_t signExtend24(uint32_t code)
+{
+    return int32_t(code << 8) >> 8;
+}
+
+inline double piecewiseValue(const CalibrationCurve &curve, double t)
+{
+    // Segment whose start is the last breakpoint <= t, clamped to the ends
+    size_t lo = 0;
+    size_t hi = curve.slope.size();
+    while (hi - lo > 1) {
+        size_t mid = (lo + hi) / 2;
+        if (curve.x[mid] <= t)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    return curve.y[lo] + (t - curve.x[lo]) * curve.slope[lo];
+}
+
+inline double scaledValue(int64_t tared, const Calibration &calibration)
+{
+    const CalibrationCurve &curve = calibration.curve;
+    double t = double(tared);
+    switch (curve.kind) {
+    case CalibrationCurve::Polynomial:
+        return (curve.c[2] * t + curve.c[1]) * t + curve.c[0];
+    case CalibrationCurve::Piecewise:
+        return piecewiseValue(curve, t);
+    case CalibrationCurve::Scale:
+        break;
+    }
+    return t / calibration.scalingFactor;
+}
+
+// Scaled units per tared unit at a tared value (the curve's slope there),
+// for converting limits and spreads given in scaled units
+double sensitivityAt(double tared, const Calibration &calibration);
+
+// Tared value the calibration converts to 0 (0 for the single factor; a
+// fitted curve need not pass through the origin). The root nearest to 0 if
+// there are several, the vertex of a parabola that never reaches 0.
+double zeroTared(const Calibration &calibration);
+
+inline ConvertedSample convertSample(uint32_t code, const Calibration &calibration)
+{
+    ConvertedSample c;
+    c.extracted = int64_t(signExtend24(code)) * 1000;
+    c.tared = c.extracted - calibration.tareValue;
+    c.grams = scaledValue(c.tared, calibration);
+    return c;
+}
+
+// Converts a run of raw codes (SSE2 where available)
+void convertBatch(const uint32_t *codes, size_t n, const Calibration &calibration,
+                  int64_t *tared, double *scaled);
@@ -0,0 +1,75 @@
+#include "adctiming.h"
+
+#include <cmath>
+
+double AdcTimingAnalyzer::rateFromCtrl2(uint8_t ctrl2)
+{
+    switch ((ctrl2 >> 4) & 0x7) {
+    case 0: return 10.0;
+    case 1: return 20.0;
+    case 2: return 40.0;
+    case 3: return 80.0;
+    case 7: return 320.0;
+    default: return 0.0;    // reserved
+    }
+}
+
+void AdcTimingAnalyzer::setRate(double rateHz)
+{
+    reset();
+    snap.rateHz = rateHz;
+}
+
+void AdcTimingAnalyzer::reset()
+{
+    double rateHz = snap.rateHz;
+    snap = AdcTimingSnapshot();
+    snap.rateHz = rateHz;
+    havePrevious = false;
+    onTime = 0;
+    mean = 0.0;
+    m2 = 0.0;
+}
+
+void AdcTimingAnalyzer::add(int64_t timestampUs, uint32_t code)
+{
+    if (!havePrevious || snap.rateHz <= 0.0) {
+        havePrevious = true;
+        previousUs = timestampUs;
+        previousCode = code;
+        return;
+    }
+
+    const double periodUs = 1e6 / snap.rateHz;
+    const double intervalUs = double(timestampUs - previousUs);
+    const double ratio = intervalUs / periodUs;
+
+    int bin = ratio <= 0.0 ? 0 : int(ratio / AdcTimingSnapshot::kBinWidth);
+    if (bin >= AdcTimingSnapshot::kBins)
+        bin = AdcTimingSnapshot::kBins - 1;
+    snap.bins[bin]++;
+    snap.intervals++;
+
+    if (ratio < 0.5 && code == previousCode) {
+        snap.duplicates++;
+    }
+    else if (ratio >= 1.5) {
+        snap.missed += uint64_t(std::llround(ratio)) - 1;
+    }
+    else if (ratio >= 0.5) {
+        onTime++;
+        double d = intervalUs - mean;
+        mean += d / double(onTime);
+        m2 += d * (intervalUs - mean);
+    }
+
+    previousUs = timestampUs;
+    previousCode = code;
+}
+
+const AdcTimingSnapshot &AdcTimingAnalyzer::snapshot() const
+{
+    snap.meanUs = mean;
+    snap.jitterUs = onTime > 1 ? std::sqrt(m2 / double(onTime - 1)) : 0.0;
+    return snap;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+struct AdcTimingSnapshot
+{
+    // Intervals in units of the expected conversion period, kBinWidth wide;
+    // the last bin collects everything beyond
+    static constexpr int kBins = 64;
+    static constexpr double kBinWidth = 1.0 / 16;
+
+    double rateHz = 0.0;
+    uint64_t intervals = 0;
+    uint64_t missed = 0;        // conversions skipped between two reads
+    uint64_t duplicates = 0;    // reads faster than a conversion, same code
+    double meanUs = 0.0;
+    double jitterUs = 0.0;      // stddev of the on-time intervals
+    std::array<uint32_t, kBins> bins{};
+};
+
+// Checks the spacing of consecutive 0x12/0x13/0x14 reads against the
+// CTRL2 conversion rate. O(1) per sample: a histogram bin, two counters
+// and a Welford update.
+class AdcTimingAnalyzer
+{
+public:
+    // NAU7802 CTRL2 (0x02) bits 6:4, conversion rate select
+    static double rateFromCtrl2(uint8_t ctrl2);
+
+    void setRate(double rateHz);
+    double rate() const { return snap.rateHz; }
+
+    void add(int64_t timestampUs, uint32_t code);
+    void reset();
+
+    const AdcTimingSnapshot &snapshot() const;
+
+private:
+    mutable AdcTimingSnapshot snap;
+    bool havePrevious = false;
+    int64_t previousUs = 0;
+    uint32_t previousCode = 0;
+
+    uint64_t onTime = 0;
+    double mean = 0.0;
+    double m2 = 0.0;
+};
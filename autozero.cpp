@@ -0,0 +1,104 @@
+#include "autozero.h"
+
+#include "adcconvert.h"
+
+#include <algorithm>
+#include <cmath>
+
+void AutoZeroTracker::configure(const AutoZeroSettings &settings)
+{
+    cfg = settings;
+    cfg.windowSamples = std::max<size_t>(cfg.windowSamples, 2);
+    cfg.minIntervalSeconds = std::max(cfg.minIntervalSeconds, 0.0);
+    cfg.minStep = std::max(cfg.minStep, 0.0);
+    lastAdjustUs = 0;
+    restartWindow();
+}
+
+void AutoZeroTracker::calibrationChanged(const Calibration &calibration)
+{
+    if (calibration.reason != "auto-zero" || !haveBase) {
+        baseTare = calibration.tareValue;
+        haveBase = true;
+    }
+    restartWindow();
+}
+
+void AutoZeroTracker::restartWindow()
+{
+    count = 0;
+    sum = 0;
+}
+
+bool AutoZeroTracker::add(int64_t timestampUs, int64_t tared, const Calibration &calibration,
+                          int64_t &newTare)
+{
+    if (!cfg.enabled)
+        return false;
+
+    if (count == 0) {
+        lo = hi = tared;
+    }
+    else {
+        lo = std::min(lo, tared);
+        hi = std::max(hi, tared);
+    }
+    sum += tared;
+    if (++count < cfg.windowSamples)
+        return false;
+
+    // ---- Once per window ----
+    // Deviations are taken from where the calibration reads 0, which for a
+    // fitted curve need not be tared 0
+    const double zero = zeroTared(calibration);
+    const double sensitivity = std::fabs(sensitivityAt(zero, calibration));
+    if (sensitivity == 0.0)
+        return false;
+    const double scale = 1.0 / sensitivity;     // tared units per scaled unit
+    const double zeroBand = cfg.zeroBand * scale;
+    const double stableBand = cfg.stableBand * scale;
+    const double mean = double(sum) / double(count) - zero;
+    const double low = double(lo) - zero;
+    const double high = double(hi) - zero;
+    const bool unloaded = std::fabs(low) <= zeroBand && std::fabs(high) <= zeroBand;
+    const bool still = double(hi - lo) <= stableBand;
+    restartWindow();
+
+    if (!haveBase) {
+        baseTare = calibration.tareValue;
+        haveBase = true;
+    }
+    if (!unloaded || !still) {
+        lastAdjustUs = 0;
+        return false;
+    }
+
+    // Rate limit: the first still window only starts the clock
+    if (lastAdjustUs == 0 || timestampUs <= lastAdjustUs) {
+        lastAdjustUs = timestampUs;
+        return false;
+    }
+    // Zero still inside the noise band: nothing to correct
+    if (low <= 0.0 && high >= 0.0)
+        return false;
+
+    // Batch adjustments, at most one per interval
+    const int64_t elapsedUs = timestampUs - lastAdjustUs;
+    if (double(elapsedUs) < cfg.minIntervalSeconds * 1e6)
+        return false;
+    double maxStep = cfg.maxRate * scale * double(elapsedUs) / 1e6;
+    double step = std::clamp(mean, -maxStep, maxStep);
+
+    double maxTotal = cfg.maxTotal * scale;
+    double target = std::clamp(double(calibration.tareValue) + step,
+                               double(baseTare) - maxTotal, double(baseTare) + maxTotal);
+    int64_t tare = std::llround(target);
+    // Too small to publish yet: the clock keeps running
+    if (tare == calibration.tareValue
+        || std::fabs(double(tare - calibration.tareValue)) < cfg.minStep * scale)
+        return false;
+    lastAdjustUs = timestampUs;
+
+    newTare = tare;
+    return true;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "calibration.h"
+
+struct AutoZeroSettings
+{
+    bool enabled = false;
+    double zeroBand = 0.5;          // |weight| considered unloaded
+    double stableBand = 0.1;        // max peak-to-peak over a window
+    size_t windowSamples = 10;
+    double maxRate = 0.05;          // max tare change per second
+    double maxTotal = 5.0;          // max distance from the operator's tare
+
+    // Every published tare is a calibration snapshot kept for the session,
+    // so adjustments are batched: at most one per interval, and none
+    // smaller than minStep
+    double minIntervalSeconds = 10.0;
+    double minStep = 0.02;
+};
+
+// Zero tracking: while the scale is unloaded and still, the tare follows
+// the slow drift of the load cell. Samples are only accumulated (sum,
+// min, max); the decision runs once per window. Bands, rate and limit are
+// in scaled units and converted with the calibration's slope at zero. The
+// tare is driven to where the calibration reads 0, so a fitted curve with
+// an offset is zeroed on its output.
+class AutoZeroTracker
+{
+public:
+    void configure(const AutoZeroSettings &settings);
+    bool isEnabled() const { return cfg.enabled; }
+
+    // Called when the decoder picks up a new calibration version. A tare
+    // set by anything but the tracker becomes the new reference.
+    void calibrationChanged(const Calibration &calibration);
+
+    // Returns true with the tare to publish when an adjustment is due
+    bool add(int64_t timestampUs, int64_t tared, const Calibration &calibration, int64_t &newTare);
+
+private:
+    void restartWindow();
+
+    AutoZeroSettings cfg;
+
+    bool haveBase = false;
+    int64_t baseTare = 0;
+    int64_t lastAdjustUs = 0;
+
+    size_t count = 0;
+    int64_t sum = 0;
+    int64_t lo = 0;
+    int64_t hi = 0;
+};
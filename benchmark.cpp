@@ -0,0 +1,573 @@
+// Headless benchmarks for the acquisition hot paths.
+//
+//   FTDI_Bench [--input capture.txt] [--reps N]
+//
+// Every stage runs once to warm up and then N times; the median is reported.
+// Self-checks of the kernels run first; a failure ends with exit status 1.
+
+#include <QApplication>
+#include <QByteArray>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QThread>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "adcconvert.h"
+#include "calibration.h"
+#include "i2cdecoder.h"
+#include "latencytrace.h"
+#include "logview.h"
+#include "samplestore.h"
+#include "textformat.h"
+
+// ---------------------------------------------------------
+// Allocation counting
+// ---------------------------------------------------------
+static std::atomic<size_t> allocations{0};
+
+void *operator new(size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+
+namespace {
+
+constexpr size_t kReadSize = 16384;     // FtdiReader buffer size
+
+struct Input
+{
+    QByteArray bytes;
+    size_t size = 0;        // up to the last complete line
+    size_t lines = 0;
+    std::vector<std::string_view> lineViews;
+    std::vector<I2cTransaction> transactions;
+    std::vector<AdcSample> samples;
+};
+
+// Deterministic sniffer stream: triplets with the odd bus glitch in between
+QByteArray syntheticCapture(size_t lines)
+{
+    QByteArray out;
+    out.reserve(lines * 24);
+
+    uint32_t lcg = 12345;
+    auto rnd = [&lcg]() { lcg = lcg * 1664525u + 1013904223u; return lcg >> 8; };
+
+    const char *regs[] = { "12", "13", "14" };
+    char buf[64];
+    for (size_t i = 0; i < lines; ++i) {
+        if (rnd() % 50 == 0) {
+            out.append("[2AWA02A[2ARA30]\r\n");
+            continue;
+        }
+        int n = std::snprintf(buf, sizeof(buf), "[2AWA%sA[2ARA%02X]\r\n",
+                              regs[i % 3], unsigned(rnd() & 0xFF));
+        out.append(buf, n);
+    }
+    return out;
+}
+
+void prepare(Input &in)
+{
+    const char *data = in.bytes.constData();
+    size_t used = forEachLine(data, in.bytes.size(), [&](std::string_view line) {
+        in.lineViews.push_back(line);
+    });
+    in.size = used;
+    in.lines = in.lineViews.size();
+
+    TripletAssembler assembler;
+    for (std::string_view line : in.lineViews) {
+        I2cTransaction txn;
+        if (parseTransaction(trimLine(line), txn) != LineKind::Transaction)
+            continue;
+        in.transactions.push_back(txn);
+        AdcSample sample;
+        if (assembler.push(txn, 0, sample))
+            in.samples.push_back(sample);
+    }
+}
+
+// ---------------------------------------------------------
+// Self-checks
+// ---------------------------------------------------------
+bool check(const char *name, bool ok)
+{
+    std::printf("check %-36s %s\n", name, ok ? "ok" : "FAILED");
+    std::fflush(stdout);
+    return ok;
+}
+
+// convertBatch() against convertSample() over every 24-bit code, compared
+// bit for bit, including the unaligned tail of the SIMD loop
+bool checkConvertBatch(const Calibration &calibration)
+{
+    constexpr size_t kChunk = 65536 + 3;
+    std::vector<uint32_t> codes(kChunk);
+    std::vector<int64_t> tared(kChunk);
+    std::vector<double> scaled(kChunk);
+
+    for (uint32_t first = 0; first < (1u << 24); first += kChunk) {
+        const size_t n = std::min<size_t>(kChunk, (1u << 24) - first);
+        for (size_t i = 0; i < n; ++i)
+            codes[i] = first + uint32_t(i);
+        convertBatch(codes.data(), n, calibration, tared.data(), scaled.data());
+        for (size_t i = 0; i < n; ++i) {
+            ConvertedSample c = convertSample(codes[i], calibration);
+            if (c.tared != tared[i] || std::memcmp(&c.grams, &scaled[i], sizeof(double)) != 0)
+                return false;
+        }
+    }
+    return true;
+}
+
+// Fits exact points of a known curve and compares the coefficients, the
+// Horner evaluation and the zero point with the direct formulas
+bool checkCalibrationFit()
+{
+    const int tare = 2625000;
+    const double c0 = 1.5, c1 = 2.5e-6, c2 = -3e-15;
+    std::vector<CalibrationPoint> points;
+    for (int i = -2; i <= 6; ++i) {
+        double t = double(i) * 1.1e6;
+        points.push_back({ t + tare, c0 + c1 * t + c2 * t * t });
+    }
+    auto close = [](double a, double b) { return std::fabs(a - b) <= 1e-9 * std::max(std::fabs(b), 1e-12); };
+
+    Calibration quadratic;
+    if (!fitCalibrationCurve(points, tare, 2, quadratic.curve))
+        return false;
+    const CalibrationCurve &q = quadratic.curve;
+    if (!close(q.c[0], c0) || !close(q.c[1], c1) || !close(q.c[2], c2))
+        return false;
+    for (int64_t t = -8000000; t <= 8000000; t += 12345) {
+        double direct = q.c[0] + q.c[1] * double(t) + q.c[2] * double(t) * double(t);
+        if (std::fabs(scaledValue(t, quadratic) - direct) > 1e-12 * std::max(std::fabs(direct), 1.0))
+            return false;
+    }
+    if (std::fabs(scaledValue(int64_t(std::llround(zeroTared(quadratic))), quadratic)) > c1)
+        return false;
+
+    // A line through the points of a line, and a piecewise curve through them
+    std::vector<CalibrationPoint> linear;
+    for (const CalibrationPoint &p : points)
+        linear.push_back({ p.extracted, c0 + c1 * (p.extracted - tare) });
+    Calibration line;
+    if (!fitCalibrationCurve(linear, tare, 1, line.curve)
+        || !close(line.curve.c[0], c0) || !close(line.curve.c[1], c1) || line.curve.c[2] != 0.0)
+        return false;
+
+    Calibration piecewise;
+    if (!fitCalibrationCurve(points, tare, 0, piecewise.curve))
+        return false;
+    for (const CalibrationPoint &p : points) {
+        if (!close(scaledValue(int64_t(p.extracted) - tare, piecewise), p.weight))
+            return false;
+    }
+    return true;
+}
+
+// Pyramid and segment tree queries against brute force, over ranges that
+// start in evicted blocks, end in the open block or lie within one block
+bool checkSampleStoreSummaries()
+{
+    SampleStore store(6 * SampleStore::kBlockSize);
+    uint32_t lcg = 777;
+    auto rnd = [&lcg]() { lcg = lcg * 1664525u + 1013904223u; return lcg >> 8; };
+
+    auto same = [](const SampleStore::Summary &a, const SampleStore::Summary &b) {
+        return a.count == b.count && a.sum == b.sum && (a.count == 0 || (a.min == b.min && a.max == b.max));
+    };
+    auto brute = [&store](uint64_t begin, uint64_t end) {
+        SampleStore::Summary s;
+        begin = std::max(begin, store.beginIndex());
+        for (uint64_t i = begin; i < std::min(end, store.endIndex()); ++i)
+            s.add(signExtend24(store.codeAt(i)));
+        return s;
+    };
+
+    int64_t timestampUs = 0;
+    for (int round = 0; round < 40; ++round) {
+        const size_t appends = 1 + rnd() % 5000;
+        for (size_t i = 0; i < appends; ++i) {
+            timestampUs += 1 + int64_t(rnd() % 2000);
+            // Mostly small codes around a level, with full-scale outliers
+            uint32_t code = rnd() % 16 ? (0x100000 + rnd() % 4096) : (rnd() & 0xFFFFFF);
+            store.append(timestampUs, code);
+        }
+
+        const uint64_t lo = store.beginIndex() - std::min<uint64_t>(store.beginIndex(), 5000);
+        const uint64_t span = store.endIndex() + 100 - lo;
+        for (int q = 0; q < 200; ++q) {
+            uint64_t a = lo + rnd() % span;
+            uint64_t b = q % 4 ? lo + rnd() % span : a + rnd() % 40;
+            if (a > b)
+                std::swap(a, b);
+            if (!same(store.summarize(a, b), brute(a, b)))
+                return false;
+
+            // Time ranges select the same samples as a scan of the timestamps
+            int64_t fromUs = int64_t(rnd() % uint32_t(timestampUs + 1));
+            int64_t toUs = fromUs + int64_t(rnd() % 3000000);
+            uint64_t begin = store.endIndex();
+            uint64_t end = store.endIndex();
+            for (uint64_t i = store.beginIndex(); i < store.endIndex(); ++i) {
+                int64_t t = store.timestampAt(i);
+                if (t >= fromUs && begin == store.endIndex())
+                    begin = i;
+                if (t >= toUs) {
+                    end = i;
+                    break;
+                }
+            }
+            if (!same(store.summarizeTime(fromUs, toUs), brute(begin, std::max(begin, end))))
+                return false;
+        }
+
+        // Buckets cover the range exactly once
+        SampleStore::Summary merged;
+        for (const SampleStore::Summary &s : store.levelOfDetail(store.beginIndex(), store.endIndex(), 37))
+            merged.merge(s);
+        if (!same(merged, brute(store.beginIndex(), store.endIndex())))
+            return false;
+    }
+    return true;
+}
+
+// Every register/value pair written in the usual layout parses back to
+// itself, so raw log rows stored as transactions render the original line
+bool checkTransactionFormat()
+{
+    for (unsigned reg = 0; reg < 256; ++reg) {
+        for (unsigned value = 0; value < 256; ++value) {
+            I2cTransaction txn{ uint8_t(reg), uint8_t(value) };
+            char text[kTransactionLineLength];
+            formatTransaction(txn, text);
+            I2cTransaction parsed{};
+            if (parseTransaction(std::string_view(text, kTransactionLineLength), parsed) != LineKind::Transaction
+                || parsed.reg != txn.reg || parsed.value != txn.value)
+                return false;
+        }
+    }
+    return true;
+}
+
+bool runChecks()
+{
+    bool ok = true;
+
+    Calibration scale;
+    ok &= check("batch conversion, scale factor", checkConvertBatch(scale));
+    Calibration negative;
+    negative.tareValue = -1234567;
+    negative.scalingFactor = -3;
+    ok &= check("batch conversion, negative factor", checkConvertBatch(negative));
+
+    Calibration polynomial;
+    std::vector<CalibrationPoint> points = { { 0.0, 0.0 }, { 4e9, 500.0 }, { 8e9, 1010.0 } };
+    ok &= fitCalibrationCurve(points, 0, 2, polynomial.curve);
+    ok &= check("batch conversion, polynomial", checkConvertBatch(polynomial));
+    Calibration piecewise;
+    points.push_back({ -4e9, -490.0 });
+    ok &= fitCalibrationCurve(points, 0, 0, piecewise.curve);
+    ok &= check("batch conversion, piecewise", checkConvertBatch(piecewise));
+
+    ok &= check("calibration fit and Horner form", checkCalibrationFit());
+    ok &= check("sample store summaries", checkSampleStoreSummaries());
+    ok &= check("transaction format round trip", checkTransactionFormat());
+
+    return ok;
+}
+
+struct Result
+{
+    double nsPerLine;
+    double mbPerSec;
+    double allocsPerLine;
+};
+
+template <typename F>
+Result measure(int reps, size_t lines, size_t bytes, F &&body)
+{
+    body();     // warm-up
+
+    std::vector<qint64> times;
+    size_t allocs = 0;
+    for (int r = 0; r < reps; ++r) {
+        size_t before = allocations.load(std::memory_order_relaxed);
+        QElapsedTimer timer;
+        timer.start();
+        body();
+        times.push_back(timer.nsecsElapsed());
+        allocs = allocations.load(std::memory_order_relaxed) - before;
+    }
+
+    std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+    double ns = double(times[times.size() / 2]);
+
+    Result result;
+    result.nsPerLine = ns / lines;
+    result.mbPerSec = bytes / (ns / 1e9) / (1024.0 * 1024.0);
+    result.allocsPerLine = double(allocs) / lines;
+    return result;
+}
+
+void report(const char *input, const char *stage, const Result &r)
+{
+    std::printf("%-10s %-22s %10.1f %10.1f %10.3f\n",
+                input, stage, r.nsPerLine, r.mbPerSec, r.allocsPerLine);
+    std::fflush(stdout);
+}
+
+volatile uint64_t sink;
+
+void runSuite(const char *name, Input &in, int reps)
+{
+    const char *data = in.bytes.constData();
+    const size_t bytes = in.size;
+    const size_t lines = in.lines;
+
+    // ---- Line splitting, in FtdiReader sized reads ----
+    report(name, "line split", measure(reps, lines, bytes, [&]() {
+        LineSplitter splitter;
+        uint64_t n = 0;
+        for (size_t off = 0; off < bytes; off += kReadSize) {
+            size_t len = std::min(kReadSize, bytes - off);
+            splitter.feed(data + off, len, [&](std::string_view line) { n += line.size(); });
+        }
+        sink = n;
+    }));
+
+    // ---- Transaction decoding ----
+    report(name, "transaction decode", measure(reps, lines, bytes, [&]() {
+        uint64_t n = 0;
+        for (std::string_view line : in.lineViews) {
+            I2cTransaction txn;
+            if (parseTransaction(trimLine(line), txn) == LineKind::Transaction)
+                n += txn.value;
+        }
+        sink = n;
+    }));
+
+    // ---- Triplet assembly ----
+    report(name, "triplet assembly", measure(reps, lines, bytes, [&]() {
+        TripletAssembler assembler;
+        uint64_t n = 0;
+        for (const I2cTransaction &txn : in.transactions) {
+            AdcSample sample;
+            if (assembler.push(txn, 0, sample))
+                n += sample.code;
+        }
+        sink = n;
+    }));
+
+    // ---- Sample conversion ----
+    report(name, "sample conversion", measure(reps, lines, bytes, [&]() {
+        Calibration calibration;
+        double n = 0;
+        for (const AdcSample &s : in.samples)
+            n += convertSample(s.code, calibration).grams;
+        sink = uint64_t(n);
+    }));
+
+    // ---- Batch conversion kernel ----
+    std::vector<uint32_t> codes;
+    for (const AdcSample &s : in.samples)
+        codes.push_back(s.code);
+    std::vector<int64_t> taredOut(codes.size());
+    std::vector<double> scaledOut(codes.size());
+    report(name, "batch conversion", measure(reps, lines, bytes, [&]() {
+        convertBatch(codes.data(), codes.size(), Calibration(), taredOut.data(), scaledOut.data());
+        sink = uint64_t(taredOut.empty() ? 0 : taredOut.back());
+    }));
+
+    // ---- History recompute after a calibration change (per sample) ----
+    SampleStore store;
+    for (const AdcSample &s : in.samples)
+        store.append(s.timestampUs, s.code);
+    Calibration calibration;
+    report(name, "history recompute", measure(reps, std::max<size_t>(in.samples.size(), 1), bytes, [&]() {
+        calibration.version++;
+        store.setCalibration(calibration);
+        double n = 0;
+        store.forEachSpan(store.beginIndex(), store.endIndex(),
+                          [&](const SampleStore::Block &b, size_t offset, size_t count) {
+            n += store.scaled(b)[offset + count - 1];
+        });
+        sink = uint64_t(n);
+    }));
+
+    // ---- Latency tracing, one record per line ----
+    report(name, "latency record", measure(reps, lines, bytes, [&]() {
+        int64_t origin = LatencyTrace::now();
+        for (size_t i = 0; i < lines; ++i)
+            LatencyTrace::record(LatencyTrace::Decode, origin);
+    }));
+
+    // ---- Reader -> GUI thread hand-off (queued QByteArray per read) ----
+    report(name, "reader hand-off", measure(reps, lines, bytes, [&]() {
+        QObject receiver;
+        std::atomic<size_t> received{0};
+
+        QThread *producer = QThread::create([&]() {
+            for (size_t off = 0; off < bytes; off += kReadSize) {
+                QByteArray chunk(data + off, int(std::min(kReadSize, bytes - off)));
+                QMetaObject::invokeMethod(&receiver, [&received, chunk]() {
+                    received.fetch_add(chunk.size(), std::memory_order_relaxed);
+                }, Qt::QueuedConnection);
+            }
+        });
+        producer->start();
+        while (received.load(std::memory_order_relaxed) < bytes)
+            QCoreApplication::processEvents(QEventLoop::AllEvents);
+        producer->wait();
+        delete producer;
+    }));
+
+    // ---- Display path, as the log models render a row ----
+    // Timestamps advance like a live capture so the per-second cache of
+    // TimestampFormatter is exercised the same way
+    const int64_t firstUs = QDateTime::currentMSecsSinceEpoch() * 1000;
+    auto lineUs = [firstUs](size_t i) { return firstUs + int64_t(i) * 1250; };
+    const size_t samples = in.samples.size();
+
+    // Raw lines as the decoder hands them on: the transaction, and the text
+    // only for lines not in the usual layout
+    std::vector<I2cTransaction> lineTxns(lines, I2cTransaction{});
+    std::vector<QByteArray> texts(lines);
+    for (size_t i = 0; i < lines; ++i) {
+        std::string_view line = trimLine(in.lineViews[i]);
+        bool usual = parseTransaction(line, lineTxns[i]) == LineKind::Transaction
+                     && line.size() == kTransactionLineLength;
+        if (usual) {
+            char text[kTransactionLineLength];
+            formatTransaction(lineTxns[i], text);
+            usual = std::memcmp(text, line.data(), kTransactionLineLength) == 0;
+        }
+        if (!usual)
+            texts[i] = QByteArray(line.data(), qsizetype(line.size()));
+    }
+
+    report(name, "display format", measure(reps, lines, bytes, [&]() {
+        TimestampFormatter timestamps;
+        Calibration calibration;
+        char buf[kTimestampLength + kMaxNumber + 4];
+        uint64_t n = 0;
+        for (size_t i = 0; i < lines; ++i) {
+            char *p = timestamps.format(buf, lineUs(i) / 1000);
+            formatTransaction(lineTxns[i], p);
+            n += size_t(p - buf) + kTransactionLineLength;
+        }
+        for (size_t i = 0; i < samples; ++i) {
+            ConvertedSample c = convertSample(in.samples[i].code, calibration);
+            char *p = timestamps.format(buf, lineUs(3 * i) / 1000);
+            n += size_t(formatInt(p, c.extracted) - buf);
+            n += size_t(formatInt(p, c.tared) - buf);
+            n += size_t(formatFixed(p, c.grams, 3) - buf);
+        }
+        sink = n;
+    }));
+
+    // ---- Log models: append per batch, then data() for every row ----
+    constexpr size_t kBatchLines = 1024;
+    report(name, "log model append", measure(reps, lines, bytes, [&]() {
+        RawLogModel raw(lines, lines / 10 + 1);
+        ValueLogModel scaled(ValueLogModel::Fixed3, samples + 1);
+        Calibration calibration;
+        for (size_t i = 0; i < lines; ++i) {
+            raw.append(lineUs(i), lineTxns[i], texts[i]);
+            if (i % 3 == 2 && i / 3 < samples)
+                scaled.append(lineUs(i - 2), convertSample(in.samples[i / 3].code, calibration).grams);
+            if (i % kBatchLines == kBatchLines - 1) {
+                raw.flush();
+                scaled.flush();
+            }
+        }
+        raw.flush();
+        scaled.flush();
+        sink = uint64_t(raw.rowCount() + scaled.rowCount());
+    }));
+
+    RawLogModel rawRows(lines, lines / 10 + 1);
+    ValueLogModel scaledRows(ValueLogModel::Fixed3, samples + 1);
+    {
+        Calibration calibration;
+        for (size_t i = 0; i < lines; ++i)
+            rawRows.append(lineUs(i), lineTxns[i], texts[i]);
+        for (size_t i = 0; i < samples; ++i)
+            scaledRows.append(lineUs(3 * i), convertSample(in.samples[i].code, calibration).grams);
+        rawRows.flush();
+        scaledRows.flush();
+    }
+    report(name, "log model data", measure(reps, lines, bytes, [&]() {
+        uint64_t n = 0;
+        for (int row = 0; row < rawRows.rowCount(); ++row)
+            n += rawRows.data(rawRows.index(row)).toString().size();
+        for (int row = 0; row < scaledRows.rowCount(); ++row)
+            n += scaledRows.data(scaledRows.index(row)).toString().size();
+        sink = n;
+    }));
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QApplication app(argc, argv);
+
+    QString inputPath;
+    int reps = 7;
+    QStringList args = app.arguments();
+    for (int i = 1; i < args.size(); ++i) {
+        if (args[i] == "--input" && i + 1 < args.size())
+            inputPath = args[++i];
+        else if (args[i] == "--reps" && i + 1 < args.size())
+            reps = std::max(1, args[++i].toInt());
+    }
+
+    if (!runChecks())
+        return 1;
+
+    std::printf("%-10s %-22s %10s %10s %10s\n", "input", "stage", "ns/line", "MB/s", "allocs/line");
+
+    Input synthetic;
+    synthetic.bytes = syntheticCapture(1000000);
+    prepare(synthetic);
+    runSuite("synthetic", synthetic, reps);
+
+    if (!inputPath.isEmpty()) {
+        QFile file(inputPath);
+        if (!file.open(QIODevice::ReadOnly)) {
+            std::fprintf(stderr, "Cannot read %s\n", qPrintable(inputPath));
+            return 1;
+        }
+        Input recorded;
+        recorded.bytes = file.readAll();
+        prepare(recorded);
+        if (recorded.lines == 0) {
+            std::fprintf(stderr, "%s contains no lines\n", qPrintable(inputPath));
+            return 1;
+        }
+        runSuite("recorded", recorded, reps);
+    }
+
+    return 0;
+}
@@ -0,0 +1,212 @@
+#include "calibration.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Solves the 3x3 (or 2x2 with n = 2) system a x = b by Gaussian elimination
+bool solve(double a[3][3], double b[3], int n, double x[3])
+{
+    for (int col = 0; col < n; ++col) {
+        int pivot = col;
+        for (int r = col + 1; r < n; ++r) {
+            if (std::fabs(a[r][col]) > std::fabs(a[pivot][col]))
+                pivot = r;
+        }
+        if (std::fabs(a[pivot][col]) < 1e-12)
+            return false;
+        std::swap(a[col], a[pivot]);
+        std::swap(b[col], b[pivot]);
+
+        for (int r = col + 1; r < n; ++r) {
+            double f = a[r][col] / a[col][col];
+            for (int k = col; k < n; ++k)
+                a[r][k] -= f * a[col][k];
+            b[r] -= f * b[col];
+        }
+    }
+    for (int r = n - 1; r >= 0; --r) {
+        double s = b[r];
+        for (int k = r + 1; k < n; ++k)
+            s -= a[r][k] * x[k];
+        x[r] = s / a[r][r];
+    }
+    return true;
+}
+
+} // namespace
+
+bool fitCalibrationCurve(const std::vector<CalibrationPoint> &points, int64_t tareValue, int degree,
+                         CalibrationCurve &curve, std::string *error)
+{
+    auto fail = [error](const char *message) {
+        if (error) *error = message;
+        return false;
+    };
+
+    // Tared values with the tare the curve is published with
+    struct Point { double tared; double weight; };
+    std::vector<Point> sorted;
+    sorted.reserve(points.size());
+    for (const CalibrationPoint &p : points)
+        sorted.push_back({ p.extracted - tareValue, p.weight });
+    std::sort(sorted.begin(), sorted.end(), [](const Point &a, const Point &b) {
+        return a.tared < b.tared;
+    });
+
+    if (degree == 0) {
+        if (sorted.size() < 2)
+            return fail("a piecewise curve needs at least 2 points");
+
+        CalibrationCurve result;
+        result.kind = CalibrationCurve::Piecewise;
+        for (const Point &p : sorted) {
+            if (!result.x.empty() && p.tared <= result.x.back())
+                return fail("two points have the same reading");
+            result.x.push_back(p.tared);
+            result.y.push_back(p.weight);
+        }
+        for (size_t i = 0; i + 1 < result.x.size(); ++i)
+            result.slope.push_back((result.y[i + 1] - result.y[i]) / (result.x[i + 1] - result.x[i]));
+        curve = std::move(result);
+        return true;
+    }
+
+    const int n = degree + 1;
+    if (degree < 1 || degree > 2)
+        return fail("only linear and quadratic fits are supported");
+    if (int(sorted.size()) < n)
+        return fail(degree == 1 ? "a linear fit needs at least 2 points"
+                                : "a quadratic fit needs at least 3 points");
+
+    // Normal equations in u = t / s keep the matrix well conditioned
+    double s = 0.0;
+    for (const Point &p : sorted)
+        s = std::max(s, std::fabs(p.tared));
+    if (s == 0.0)
+        return fail("all readings are zero");
+
+    double a[3][3] = {};
+    double b[3] = {};
+    for (const Point &p : sorted) {
+        double u = p.tared / s;
+        double pw[5] = { 1.0, u, u * u, u * u * u, u * u * u * u };
+        for (int r = 0; r < n; ++r) {
+            for (int k = 0; k < n; ++k)
+                a[r][k] += pw[r + k];
+            b[r] += pw[r] * p.weight;
+        }
+    }
+
+    double coef[3] = {};
+    if (!solve(a, b, n, coef))
+        return fail("the readings do not determine the curve");
+
+    CalibrationCurve result;
+    result.kind = CalibrationCurve::Polynomial;
+    result.c[0] = coef[0];
+    result.c[1] = coef[1] / s;
+    result.c[2] = coef[2] / (s * s);
+    curve = std::move(result);
+    return true;
+}
+
+CalibrationRegistry::CalibrationRegistry()
+{
+    snapshots.push_back(std::make_unique<Calibration>());
+    records.push_back({ *snapshots.back() });
+    currentPtr.store(snapshots.back().get(), std::memory_order_release);
+}
+
+const Calibration *CalibrationRegistry::publish(int64_t tareValue, int scalingFactor,
+                                                const std::string &reason)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto snapshot = std::make_unique<Calibration>(*snapshots.back());
+    snapshot->tareValue = tareValue;
+    snapshot->scalingFactor = scalingFactor;
+    snapshot->curve = CalibrationCurve();
+    snapshot->reason = reason;
+
+    return append(std::move(snapshot));
+}
+
+const Calibration *CalibrationRegistry::publishScaling(int scalingFactor,
+                                                       const std::string &reason)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto snapshot = std::make_unique<Calibration>(*snapshots.back());
+    snapshot->scalingFactor = scalingFactor;
+    snapshot->curve = CalibrationCurve();
+    snapshot->reason = reason;
+
+    return append(std::move(snapshot));
+}
+
+const Calibration *CalibrationRegistry::publishTare(int64_t tareValue, const std::string &reason)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto snapshot = std::make_unique<Calibration>(*snapshots.back());
+    snapshot->tareValue = tareValue;
+    snapshot->reason = reason;
+
+    return append(std::move(snapshot));
+}
+
+const Calibration *CalibrationRegistry::publishCurve(const CalibrationCurve &curve,
+                                                     const std::string &reason)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto snapshot = std::make_unique<Calibration>(*snapshots.back());
+    snapshot->curve = curve;
+    snapshot->reason = reason;
+
+    return append(std::move(snapshot));
+}
+
+const Calibration *CalibrationRegistry::append(std::unique_ptr<Calibration> snapshot)
+{
+    snapshot->version++;
+
+    const Calibration *published = snapshot.get();
+    records.push_back({ *snapshot });
+    snapshots.push_back(std::move(snapshot));
+    currentPtr.store(published, std::memory_order_release);
+    return published;
+}
+
+void CalibrationRegistry::markEffective(uint32_t version, uint64_t fromSample, int64_t fromUs)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // Versions are consecutive from 1
+    if (version == 0 || version > records.size())
+        return;
+    CalibrationRecord &r = records[version - 1];
+    if (r.effective)
+        return;
+    r.effective = true;
+    r.fromSample = fromSample;
+    r.fromUs = fromUs;
+}
+
+std::vector<CalibrationRecord> CalibrationRegistry::history() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return records;
+}
+
+const Calibration *CalibrationRegistry::find(uint32_t version) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // Versions are consecutive from 1
+    if (version == 0 || version > snapshots.size())
+        return nullptr;
+    return snapshots[version - 1].get();
+}
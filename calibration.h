@@ -0,0 +1,106 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Maps a tared value to the scaled unit. 'Scale' is the single factor
+// (tared / scalingFactor); the others come from a multi-point calibration.
+struct CalibrationCurve
+{
+    enum Kind : uint8_t { Scale, Polynomial, Piecewise };
+
+    Kind kind = Scale;
+
+    // Polynomial: c[0] + c[1] t + c[2] t^2, evaluated in Horner form
+    double c[3] = {};
+
+    // Piecewise linear: ascending breakpoints x (tared) -> y, with the slope
+    // of each segment precomputed; the end segments extrapolate
+    std::vector<double> x;
+    std::vector<double> y;
+    std::vector<double> slope;
+};
+
+// Parameters turning raw ADC codes into tared and scaled values. The
+// version changes with every edit so derived data can tell it is stale.
+struct Calibration
+{
+    uint32_t version = 1;
+    int64_t tareValue = 2625000;
+    int scalingFactor = 399835;
+    CalibrationCurve curve;
+    std::string reason = "default";
+};
+
+// Extracted values span +-2^23 * 1000, a tare outside that is no reading
+constexpr int64_t kTareLimit = (int64_t(1) << 23) * 1000;
+
+// Averaged reading at a reference weight, kept as code * 1000 so points are
+// independent of tare changes (auto-zero) while they are collected
+struct CalibrationPoint
+{
+    double extracted;
+    double weight;
+};
+
+// Least-squares fit of 'degree' 1 or 2, or a piecewise-linear curve through
+// the points (degree 0), over the tared values with 'tareValue'. Returns
+// false with a message if the points do not determine the curve.
+bool fitCalibrationCurve(const std::vector<CalibrationPoint> &points, int64_t tareValue, int degree,
+                         CalibrationCurve &curve, std::string *error = nullptr);
+
+struct CalibrationRecord
+{
+    Calibration calibration;
+    bool effective = false;     // set once the decoder has used it
+    uint64_t fromSample = 0;    // first sample converted with it
+    int64_t fromUs = 0;         // timestamp of that sample
+};
+
+// Publishes immutable calibration snapshots RCU style: the GUI builds a new
+// snapshot and swaps the current pointer, the decoder loads it lock-free
+// for every sample. Snapshots are never freed, they form the history.
+class CalibrationRegistry
+{
+public:
+    CalibrationRegistry();
+
+    const Calibration *current() const { return currentPtr.load(std::memory_order_acquire); }
+
+    // Takes effect from the next sample the decoder converts. A scaling
+    // factor replaces any multi-point curve.
+    const Calibration *publish(int64_t tareValue, int scalingFactor, const std::string &reason);
+
+    // Keeps the tare of the latest snapshot and replaces any curve, so a
+    // concurrent auto-zero tare is not reverted
+    const Calibration *publishScaling(int scalingFactor, const std::string &reason);
+
+    // Keeps tare and scaling factor, replaces the curve
+    const Calibration *publishCurve(const CalibrationCurve &curve, const std::string &reason);
+
+    // Changes only the tare of the latest snapshot, so a concurrent scaling
+    // change from the GUI is not lost
+    const Calibration *publishTare(int64_t tareValue, const std::string &reason);
+
+    // Decoder side: records the first sample converted with a version
+    void markEffective(uint32_t version, uint64_t fromSample, int64_t fromUs);
+
+    std::vector<CalibrationRecord> history() const;
+
+    // Snapshot of a version, nullptr if it was never published
+    const Calibration *find(uint32_t version) const;
+
+private:
+    // Caller holds the mutex; 'snapshot' is a copy of the latest one
+    const Calibration *append(std::unique_ptr<Calibration> snapshot);
+
+    mutable std::mutex mutex;
+    std::deque<std::unique_ptr<Calibration>> snapshots;
+    std::vector<CalibrationRecord> records;
+    std::atomic<const Calibration *> currentPtr;
+};
@@ -0,0 +1,150 @@
+#include "checkweigher.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr int64_t kRateWindowUs = 60 * 1000000;
+
+} // namespace
+
+void Checkweigher::configure(const CheckweigherSettings &settings)
+{
+    cfg = settings;
+    cfg.settleSamples = std::max<size_t>(cfg.settleSamples, 1);
+    cfg.unloadThreshold = std::min(cfg.unloadThreshold, cfg.loadThreshold);
+    loaded = false;
+}
+
+void Checkweigher::newBatch()
+{
+    count = 0;
+    mean = m2 = 0.0;
+    under = over = unsettled = 0;
+    recentLoads.clear();
+}
+
+CheckweighStats Checkweigher::stats() const
+{
+    CheckweighStats s;
+    s.count = count;
+    s.mean = mean;
+    s.stddev = count > 1 ? std::sqrt(m2 / double(count - 1)) : 0.0;
+    s.under = under;
+    s.over = over;
+    s.unsettled = unsettled;
+
+    // Until a minute has passed, extrapolate from the span seen so far
+    if (recentLoads.size() >= 2) {
+        int64_t span = recentLoads.back() - recentLoads.front();
+        if (span > 0)
+            s.itemsPerMinute = double(recentLoads.size() - 1) * 60e6 / double(span);
+    }
+    return s;
+}
+
+void Checkweigher::startItem(int64_t timestampUs)
+{
+    loaded = true;
+    loadUs = timestampUs;
+    loadSamples = 0;
+    loadSum = 0.0;
+
+    plateau.clear();
+    minQueue.clear();
+    maxQueue.clear();
+    plateauSum = 0.0;
+    sinceReseed = 0;
+    haveBest = false;
+}
+
+bool Checkweigher::add(int64_t timestampUs, double value, CheckweighItem &item)
+{
+    if (!cfg.enabled)
+        return false;
+
+    if (!loaded) {
+        if (value > cfg.loadThreshold)
+            startItem(timestampUs);
+        else
+            return false;
+    }
+    else if (value < cfg.unloadThreshold) {
+        loaded = false;
+        if (loadSamples < cfg.minSamples)
+            return false;
+        finishItem(timestampUs, item);
+        return true;
+    }
+
+    loadSamples++;
+    loadSum += value;
+
+    // Sliding plateau window with monotonic min/max queues
+    index++;
+    plateau.push_back(value);
+    plateauSum += value;
+    while (!minQueue.empty() && minQueue.back().value >= value)
+        minQueue.pop_back();
+    minQueue.push_back({ index, value });
+    while (!maxQueue.empty() && maxQueue.back().value <= value)
+        maxQueue.pop_back();
+    maxQueue.push_back({ index, value });
+
+    if (plateau.size() > cfg.settleSamples) {
+        plateauSum -= plateau.front();
+        plateau.pop_front();
+        uint64_t oldest = index - cfg.settleSamples;
+        if (minQueue.front().index <= oldest)
+            minQueue.pop_front();
+        if (maxQueue.front().index <= oldest)
+            maxQueue.pop_front();
+    }
+
+    // Re-sum once per window so rounding does not accumulate
+    if (++sinceReseed >= cfg.settleSamples) {
+        plateauSum = 0.0;
+        for (size_t i = 0; i < plateau.size(); ++i)
+            plateauSum += plateau[i];
+        sinceReseed = 0;
+    }
+
+    if (plateau.size() == cfg.settleSamples) {
+        double spread = maxQueue.front().value - minQueue.front().value;
+        if (spread <= cfg.settleBand && (!haveBest || spread <= bestSpread)) {
+            haveBest = true;
+            bestSpread = spread;
+            bestWeight = plateauSum / double(plateau.size());
+        }
+    }
+    return false;
+}
+
+void Checkweigher::finishItem(int64_t timestampUs, CheckweighItem &item)
+{
+    item.sequence = nextSequence++;
+    item.loadUs = loadUs;
+    item.durationUs = timestampUs - loadUs;
+    item.settled = haveBest;
+    item.weight = haveBest ? bestWeight : loadSum / double(loadSamples);
+    item.spread = haveBest ? bestSpread : 0.0;
+
+    item.verdict = CheckweighItem::Ok;
+    if (cfg.lowerLimit > 0.0 && item.weight < cfg.lowerLimit)
+        item.verdict = CheckweighItem::Under;
+    else if (cfg.upperLimit > 0.0 && item.weight > cfg.upperLimit)
+        item.verdict = CheckweighItem::Over;
+
+    count++;
+    double d = item.weight - mean;
+    mean += d / double(count);
+    m2 += d * (item.weight - mean);
+    under += item.verdict == CheckweighItem::Under;
+    over += item.verdict == CheckweighItem::Over;
+    unsettled += !item.settled;
+
+    recentLoads.push_back(loadUs);
+    while (recentLoads.front() < loadUs - kRateWindowUs)
+        recentLoads.pop_front();
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "ringdeque.h"
+
+struct CheckweigherSettings
+{
+    bool enabled = false;
+    double loadThreshold = 5.0;     // rising above starts an item
+    double unloadThreshold = 2.0;   // falling below ends it
+    double settleBand = 0.5;        // max peak-to-peak of a settled plateau
+    size_t settleSamples = 5;       // plateau length
+    size_t minSamples = 3;          // shorter loads are ignored as glitches
+    double lowerLimit = 0.0;        // 0 = no limit
+    double upperLimit = 0.0;        // 0 = no limit
+};
+
+struct CheckweighItem
+{
+    enum Verdict : uint8_t { Ok, Under, Over };
+
+    uint64_t sequence;
+    int64_t loadUs;             // first sample above the load threshold
+    int64_t durationUs;         // until the first sample below unload
+    double weight;              // flattest plateau, or the load mean if unsettled
+    double spread;              // peak-to-peak of that plateau
+    bool settled;
+    Verdict verdict;
+};
+
+// Running statistics of the items since the last newBatch()
+struct CheckweighStats
+{
+    uint64_t count = 0;
+    double mean = 0.0;
+    double stddev = 0.0;
+    uint64_t under = 0;
+    uint64_t over = 0;
+    uint64_t unsettled = 0;
+    double itemsPerMinute = 0.0;    // over the last minute
+};
+
+// Segments the filtered weight into load/unload cycles with hysteresis.
+// While an item is on the cell a sliding window of settleSamples values
+// keeps its min and max in monotonic queues; the flattest window in the
+// band gives the settled weight. All buffers are reused, so an item costs
+// no allocation once the rings have grown.
+class Checkweigher
+{
+public:
+    void configure(const CheckweigherSettings &settings);
+    const CheckweigherSettings &settings() const { return cfg; }
+
+    // Returns true and fills 'item' when an item leaves the cell
+    bool add(int64_t timestampUs, double value, CheckweighItem &item);
+
+    void newBatch();
+    CheckweighStats stats() const;
+
+private:
+    struct Point
+    {
+        uint64_t index;
+        double value;
+    };
+
+    void startItem(int64_t timestampUs);
+    void finishItem(int64_t timestampUs, CheckweighItem &item);
+
+    CheckweigherSettings cfg;
+
+    bool loaded = false;
+    int64_t loadUs = 0;
+    uint64_t loadSamples = 0;
+    double loadSum = 0.0;
+
+    // Plateau window of the current item
+    uint64_t index = 0;
+    RingDeque<double> plateau;
+    RingDeque<Point> minQueue;
+    RingDeque<Point> maxQueue;
+    double plateauSum = 0.0;
+    size_t sinceReseed = 0;
+    bool haveBest = false;
+    double bestWeight = 0.0;
+    double bestSpread = 0.0;
+
+    // Batch statistics, Welford
+    uint64_t nextSequence = 1;
+    uint64_t count = 0;
+    double mean = 0.0;
+    double m2 = 0.0;
+    uint64_t under = 0;
+    uint64_t over = 0;
+    uint64_t unsettled = 0;
+    RingDeque<int64_t> recentLoads;     // load times within the last minute
+};
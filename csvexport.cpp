@@ -0,0 +1,196 @@
+#include "csvexport.h"
+
+#include <QFile>
+#include <algorithm>
+#include <charconv>
+
+#include "rollups.h"
+#include "samplestore.h"
+#include "triggerengine.h"
+
+namespace {
+
+constexpr size_t kMaxField = 64;
+
+} // namespace
+
+CsvWriter::CsvWriter(QIODevice *device, size_t bufferSize)
+    : device(device), buf(std::max(bufferSize, kMaxField))
+{
+}
+
+CsvWriter::~CsvWriter()
+{
+    flush();
+}
+
+char *CsvWriter::reserve(size_t n)
+{
+    if (buf.size() - used < n)
+        flush();
+    if (buf.size() < n)
+        buf.resize(n);
+    return buf.data() + used;
+}
+
+void CsvWriter::separator()
+{
+    if (!rowStart) {
+        *reserve(1) = ',';
+        used++;
+    }
+    rowStart = false;
+}
+
+CsvWriter &CsvWriter::field(std::string_view text)
+{
+    separator();
+    char *p = reserve(text.size());
+    std::copy(text.begin(), text.end(), p);
+    used += text.size();
+    return *this;
+}
+
+CsvWriter &CsvWriter::field(int64_t value)
+{
+    separator();
+    char *p = reserve(kMaxField);
+    used = std::to_chars(p, buf.data() + buf.size(), value).ptr - buf.data();
+    return *this;
+}
+
+CsvWriter &CsvWriter::field(uint64_t value)
+{
+    separator();
+    char *p = reserve(kMaxField);
+    used = std::to_chars(p, buf.data() + buf.size(), value).ptr - buf.data();
+    return *this;
+}
+
+CsvWriter &CsvWriter::field(double value, int decimals)
+{
+    separator();
+    char *p = reserve(kMaxField);
+    auto res = std::to_chars(p, buf.data() + buf.size(), value, std::chars_format::fixed, decimals);
+    if (res.ec != std::errc())
+        res = std::to_chars(p, buf.data() + buf.size(), value);
+    used = res.ptr - buf.data();
+    return *this;
+}
+
+void CsvWriter::endRow()
+{
+    *reserve(1) = '\n';
+    used++;
+    rowStart = true;
+}
+
+bool CsvWriter::flush()
+{
+    if (used && device->write(buf.data(), qint64(used)) != qint64(used))
+        ok = false;
+    used = 0;
+    return ok;
+}
+
+bool exportSamplesCsv(const SampleStore &store, const std::vector<CalibrationRecord> &history,
+                      const QString &path, QString *error)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        if (error) *error = file.errorString();
+        return false;
+    }
+
+    // Effective versions in acquisition order
+    std::vector<const CalibrationRecord *> effective;
+    for (const CalibrationRecord &r : history) {
+        if (r.effective)
+            effective.push_back(&r);
+    }
+    size_t next = 0;
+    uint64_t version = 0;
+
+    CsvWriter csv(&file);
+    csv.field("timestamp_us").field("code").field("tared").field("scaled").field("calibration");
+    csv.endRow();
+
+    store.forEachSpan(store.beginIndex(), store.endIndex(),
+                      [&](const SampleStore::Block &b, size_t offset, size_t count) {
+        const int64_t *tared = store.tared(b);
+        const double *scaled = store.scaled(b);
+        for (size_t i = offset; i < offset + count; ++i) {
+            while (next < effective.size() && effective[next]->fromSample <= b.firstIndex + i)
+                version = effective[next++]->calibration.version;
+
+            csv.field(int64_t(b.timestampUs[i]))
+               .field(uint64_t(b.code[i]))
+               .field(int64_t(tared[i]))
+               .field(scaled[i], 3)
+               .field(version);
+            csv.endRow();
+        }
+    });
+
+    if (!csv.flush()) {
+        if (error) *error = file.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool exportCaptureCsv(const TriggerCapture &capture, const QString &path, QString *error)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        if (error) *error = file.errorString();
+        return false;
+    }
+
+    CsvWriter csv(&file);
+    csv.field("offset_us").field("timestamp_us").field("value");
+    csv.endRow();
+
+    for (const TriggerCapture::Point &p : capture.points) {
+        csv.field(int64_t(p.timestampUs - capture.triggerUs))
+           .field(int64_t(p.timestampUs))
+           .field(p.value, 3);
+        csv.endRow();
+    }
+
+    if (!csv.flush()) {
+        if (error) *error = file.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool exportRollupsCsv(const RollupTable &seconds, const RollupTable &minutes,
+                      const std::vector<CalibrationRecord> &history, const QString &path,
+                      QString *error)
+{
+    // Versions are consecutive from 1
+    auto calibration = [&history](const Rollup &r) -> const Calibration & {
+        size_t i = r.calibrationVersion ? size_t(r.calibrationVersion - 1) : 0;
+        return history[std::min(i, history.size() - 1)].calibration;
+    };
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        if (error) *error = file.errorString();
+        return false;
+    }
+
+    CsvWriter csv(&file);
+    writeRollupHeader(csv);
+    for (const Rollup &r : seconds.all())
+        writeRollupRow(csv, r, calibration(r));
+    for (const Rollup &r : minutes.all())
+        writeRollupRow(csv, r, calibration(r));
+
+    if (!csv.flush()) {
+        if (error) *error = file.errorString();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <QIODevice>
+#include <QString>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "calibration.h"
+
+class RollupTable;
+class SampleStore;
+struct TriggerCapture;
+
+// Buffered CSV output with std::to_chars, QTextStream is far too slow for
+// millions of rows
+class CsvWriter
+{
+public:
+    explicit CsvWriter(QIODevice *device, size_t bufferSize = 1 << 20);
+    ~CsvWriter();
+
+    CsvWriter &field(std::string_view text);
+    CsvWriter &field(int64_t value);
+    CsvWriter &field(uint64_t value);
+    CsvWriter &field(double value, int decimals);
+    void endRow();
+
+    bool flush();
+
+private:
+    char *reserve(size_t n);
+    void separator();
+
+    QIODevice *device;
+    std::vector<char> buf;
+    size_t used = 0;
+    bool rowStart = true;
+    bool ok = true;
+};
+
+// Writes every held sample as timestamp_us,code,tared,scaled,calibration.
+// tared/scaled use the current calibration; the last column is the version
+// that was live when the sample was acquired.
+bool exportSamplesCsv(const SampleStore &store, const std::vector<CalibrationRecord> &history,
+                      const QString &path, QString *error = nullptr);
+
+// Writes a trigger capture as offset_us,timestamp_us,value; offsets are
+// relative to the trigger sample
+bool exportCaptureCsv(const TriggerCapture &capture, const QString &path, QString *error = nullptr);
+
+// Writes the per-second and per-minute rollups, each converted with its
+// calibration version from 'history'
+bool exportRollupsCsv(const RollupTable &seconds, const RollupTable &minutes,
+                      const std::vector<CalibrationRecord> &history, const QString &path,
+                      QString *error = nullptr);
@@ -0,0 +1,425 @@
+#include "filters.h"
+
+#include <QRegularExpression>
+#include <QStringList>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr size_t kMaxLength = 4096;
+constexpr size_t kMaxMedianLength = 255;
+constexpr size_t kMaxOrder = 5;
+constexpr double kPi = 3.14159265358979323846;
+
+} // namespace
+
+// ---------------------------------------------------------
+// Moving average
+// ---------------------------------------------------------
+MovingAverageFilter::MovingAverageFilter(size_t length)
+    : window(std::max<size_t>(length, 1))
+{
+}
+
+size_t MovingAverageFilter::process(int64_t *, double *values, size_t count)
+{
+    const size_t n = window.size();
+    for (size_t i = 0; i < count; ++i) {
+        double x = values[i];
+        if (filled == n)
+            sum -= window[head];
+        else
+            filled++;
+        window[head] = x;
+        sum += x;
+
+        if (++head == n) {
+            head = 0;
+            // Re-add once per window so rounding cannot accumulate
+            if (filled == n) {
+                sum = 0.0;
+                for (double v : window)
+                    sum += v;
+            }
+        }
+        values[i] = sum / double(filled);
+    }
+    return count;
+}
+
+void MovingAverageFilter::reset()
+{
+    head = 0;
+    filled = 0;
+    sum = 0.0;
+}
+
+QString MovingAverageFilter::describe() const
+{
+    return QString("movavg:%1").arg(window.size());
+}
+
+// ---------------------------------------------------------
+// Median
+// ---------------------------------------------------------
+MedianFilter::MedianFilter(size_t length)
+    : length(length | 1)
+{
+    window.reserve(this->length);
+    sorted.reserve(this->length);
+}
+
+size_t MedianFilter::process(int64_t *, double *values, size_t count)
+{
+    const size_t n = length;
+    for (size_t i = 0; i < count; ++i) {
+        double x = values[i];
+        if (window.size() < n) {
+            window.push_back(x);
+        }
+        else {
+            double old = window[head];
+            sorted.erase(std::lower_bound(sorted.begin(), sorted.end(), old));
+            window[head] = x;
+            head = (head + 1) % n;
+        }
+        sorted.insert(std::upper_bound(sorted.begin(), sorted.end(), x), x);
+
+        // While filling up, the median of what has arrived so far
+        size_t m = sorted.size();
+        values[i] = (m & 1) ? sorted[m / 2] : 0.5 * (sorted[m / 2 - 1] + sorted[m / 2]);
+    }
+    return count;
+}
+
+void MedianFilter::reset()
+{
+    window.clear();
+    sorted.clear();
+    head = 0;
+}
+
+QString MedianFilter::describe() const
+{
+    return QString("median:%1").arg(length);
+}
+
+// ---------------------------------------------------------
+// Butterworth low-pass
+// ---------------------------------------------------------
+LowPassFilter::LowPassFilter(double cutoffHz, double sampleRateHz)
+    : cutoffHz(cutoffHz)
+{
+    design(sampleRateHz);
+}
+
+void LowPassFilter::design(double sampleRateHz)
+{
+    // Bilinear transform with pre-warping, Q = 1/sqrt(2)
+    const double k = std::tan(kPi * cutoffHz / sampleRateHz);
+    const double q = 1.0 / std::sqrt(2.0);
+    const double norm = 1.0 / (1.0 + k / q + k * k);
+    b0 = k * k * norm;
+    b1 = 2.0 * b0;
+    b2 = b0;
+    a1 = 2.0 * (k * k - 1.0) * norm;
+    a2 = (1.0 - k / q + k * k) * norm;
+}
+
+size_t LowPassFilter::process(int64_t *, double *values, size_t count)
+{
+    if (count && !primed) {
+        // Start in steady state at the first input instead of ramping up from 0
+        double x = values[0];
+        z1 = x - b0 * x;
+        z2 = b2 * x - a2 * x;
+        primed = true;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        double x = values[i];
+        double y = b0 * x + z1;
+        z1 = b1 * x - a1 * y + z2;
+        z2 = b2 * x - a2 * y;
+        values[i] = y;
+    }
+    return count;
+}
+
+void LowPassFilter::reset()
+{
+    z1 = z2 = 0.0;
+    primed = false;
+}
+
+QString LowPassFilter::describe() const
+{
+    return QString("lowpass:%1").arg(cutoffHz);
+}
+
+bool LowPassFilter::setSampleRate(double sampleRateHz, QString *error)
+{
+    if (cutoffHz >= sampleRateHz / 2) {
+        if (error)
+            *error = QString("lowpass cutoff must be below %1 Hz").arg(sampleRateHz / 2);
+        return false;
+    }
+    design(sampleRateHz);
+    // The old state belongs to the old coefficients; restart settled on the
+    // next input
+    primed = false;
+    return true;
+}
+
+// ---------------------------------------------------------
+// CIC / boxcar decimator
+// ---------------------------------------------------------
+DecimatorFilter::DecimatorFilter(size_t factor, size_t order)
+    : factor(std::max<size_t>(factor, 1))
+{
+    for (size_t i = 1; i < order; ++i)
+        smoothing.emplace_back(this->factor);
+}
+
+size_t DecimatorFilter::process(int64_t *timestampsUs, double *values, size_t count)
+{
+    for (MovingAverageFilter &stage : smoothing)
+        stage.process(timestampsUs, values, count);
+
+    // The last boxcar is evaluated only at the output instants. An output
+    // carries the timestamp of the newest input it covers.
+    size_t out = 0;
+    for (size_t i = 0; i < count; ++i) {
+        sum += values[i];
+        if (++phase == factor) {
+            timestampsUs[out] = timestampsUs[i];
+            values[out] = sum / double(factor);
+            out++;
+            phase = 0;
+            sum = 0.0;
+        }
+    }
+    return out;
+}
+
+void DecimatorFilter::reset()
+{
+    for (MovingAverageFilter &stage : smoothing)
+        stage.reset();
+    phase = 0;
+    sum = 0.0;
+}
+
+QString DecimatorFilter::describe() const
+{
+    if (smoothing.empty())
+        return QString("decimate:%1").arg(factor);
+    return QString("decimate:%1:%2").arg(factor).arg(smoothing.size() + 1);
+}
+
+KalmanFilter::KalmanFilter(double processNoise, double measurementNoise, Model model,
+                           double sampleRateHz)
+    : q2(processNoise * processNoise),
+      r2(measurementNoise * measurementNoise),
+      model(model),
+      nominalDt(1.0 / sampleRateHz)
+{
+}
+
+size_t KalmanFilter::process(int64_t *timestampsUs, double *values, size_t count)
+{
+    sigma.resize(count);
+
+    for (size_t i = 0; i < count; ++i) {
+        const double z = values[i];
+
+        if (!primed) {
+            // First measurement sets the state; a velocity of one noise
+            // step per sample is plausible
+            x = z;
+            v = 0.0;
+            pxx = r2;
+            pxv = 0.0;
+            pvv = r2 / (nominalDt * nominalDt);
+            primed = true;
+        }
+        else {
+            double dt = double(timestampsUs[i] - lastUs) * 1e-6;
+            if (dt <= 0.0)
+                dt = nominalDt;
+
+            // Predict
+            if (model == Motion) {
+                x += v * dt;
+                pxx += dt * (2.0 * pxv + dt * pvv) + q2 * dt * dt * dt / 3.0;
+                pxv += dt * pvv + q2 * dt * dt / 2.0;
+                pvv += q2 * dt;
+            }
+            else {
+                pxx += q2 * dt;
+            }
+
+            // Update with the scalar innovation
+            const double s = pxx + r2;
+            const double kx = pxx / s;
+            const double kv = pxv / s;
+            const double innovation = z - x;
+            x += kx * innovation;
+            v += kv * innovation;
+            pvv -= kv * pxv;
+            pxv -= kx * pxv;
+            pxx -= kx * pxx;
+        }
+
+        lastUs = timestampsUs[i];
+        values[i] = x;
+        sigma[i] = std::sqrt(std::max(pxx, 0.0));
+    }
+    return count;
+}
+
+bool KalmanFilter::setSampleRate(double sampleRateHz, QString *)
+{
+    nominalDt = 1.0 / sampleRateHz;
+    return true;
+}
+
+void KalmanFilter::reset()
+{
+    primed = false;
+    x = v = 0.0;
+    pxx = pxv = pvv = 0.0;
+}
+
+QString KalmanFilter::describe() const
+{
+    return QString("kalman:%1:%2:%3")
+        .arg(std::sqrt(q2), 0, 'g', 4)
+        .arg(std::sqrt(r2), 0, 'g', 4)
+        .arg(model == Motion ? 1 : 0);
+}
+
+// ---------------------------------------------------------
+// Chain
+// ---------------------------------------------------------
+bool FilterChain::parse(const QString &spec, double sampleRateHz, FilterChain &chain,
+                        QString *error)
+{
+    auto fail = [error](const QString &message) {
+        if (error) *error = message;
+        return false;
+    };
+
+    std::vector<std::unique_ptr<FilterStage>> stages;
+    double rateHz = sampleRateHz;       // at the input of the next stage
+
+    const QStringList items = spec.split(QRegularExpression("[,;]"), Qt::SkipEmptyParts);
+    for (const QString &item : items) {
+        QStringList parts = item.trimmed().split(':');
+        QString name = parts[0].trimmed().toLower();
+        if (name.isEmpty())
+            continue;
+
+        bool ok = parts.size() >= 2;
+        double arg = ok ? parts[1].toDouble(&ok) : 0.0;
+        if (!ok || arg <= 0)
+            return fail(QString("'%1' needs a positive parameter").arg(item.trimmed()));
+
+        if (name == "movavg" || name == "avg") {
+            if (arg > kMaxLength)
+                return fail(QString("movavg length is limited to %1").arg(kMaxLength));
+            stages.push_back(std::make_unique<MovingAverageFilter>(size_t(arg)));
+        }
+        else if (name == "median") {
+            if (arg > kMaxMedianLength)
+                return fail(QString("median length is limited to %1").arg(kMaxMedianLength));
+            stages.push_back(std::make_unique<MedianFilter>(size_t(arg)));
+        }
+        else if (name == "lowpass" || name == "lp") {
+            if (arg >= rateHz / 2)
+                return fail(QString("lowpass cutoff must be below %1 Hz").arg(rateHz / 2));
+            stages.push_back(std::make_unique<LowPassFilter>(arg, rateHz));
+        }
+        else if (name == "decimate" || name == "cic" || name == "boxcar") {
+            size_t order = 1;
+            if (parts.size() >= 3) {
+                order = parts[2].toUInt(&ok);
+                if (!ok || order == 0 || order > kMaxOrder)
+                    return fail(QString("decimator order must be 1..%1").arg(kMaxOrder));
+            }
+            if (arg > kMaxLength)
+                return fail(QString("decimation factor is limited to %1").arg(kMaxLength));
+            stages.push_back(std::make_unique<DecimatorFilter>(size_t(arg), order));
+            rateHz /= double(size_t(arg));
+        }
+        else if (name == "kalman") {
+            bool okR = parts.size() >= 3;
+            double r = okR ? parts[2].toDouble(&okR) : 0.0;
+            if (!okR || r <= 0)
+                return fail("kalman needs process and measurement noise, e.g. kalman:0.01:0.5");
+            KalmanFilter::Model model = KalmanFilter::Constant;
+            if (parts.size() >= 4) {
+                unsigned m = parts[3].toUInt(&ok);
+                if (!ok || m > 1)
+                    return fail("kalman model must be 0 (constant) or 1 (motion)");
+                model = m ? KalmanFilter::Motion : KalmanFilter::Constant;
+            }
+            stages.push_back(std::make_unique<KalmanFilter>(arg, r, model, rateHz));
+        }
+        else {
+            return fail(QString("Unknown filter '%1'").arg(name));
+        }
+    }
+
+    chain.stages = std::move(stages);
+    return true;
+}
+
+size_t FilterChain::process(int64_t *timestampsUs, double *values, size_t count)
+{
+    for (const std::unique_ptr<FilterStage> &stage : stages) {
+        if (count == 0)
+            break;
+        count = stage->process(timestampsUs, values, count);
+    }
+    return count;
+}
+
+const double *FilterChain::uncertainty() const
+{
+    return stages.empty() ? nullptr : stages.back()->uncertainty();
+}
+
+bool FilterChain::setSampleRate(double sampleRateHz, QString *error)
+{
+    double rateHz = sampleRateHz;
+    for (const std::unique_ptr<FilterStage> &stage : stages) {
+        if (!stage->setSampleRate(rateHz, error))
+            return false;
+        rateHz /= double(stage->decimation());
+    }
+    return true;
+}
+
+void FilterChain::reset()
+{
+    for (const std::unique_ptr<FilterStage> &stage : stages)
+        stage->reset();
+}
+
+size_t FilterChain::decimation() const
+{
+    size_t total = 1;
+    for (const std::unique_ptr<FilterStage> &stage : stages)
+        total *= stage->decimation();
+    return total;
+}
+
+QString FilterChain::describe() const
+{
+    QStringList parts;
+    for (const std::unique_ptr<FilterStage> &stage : stages)
+        parts << stage->describe();
+    return parts.isEmpty() ? QString("none") : parts.join(", ");
+}
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <QString>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// One stage of the weight channel filter. Stages work in place on a block
+// of samples; a decimating stage compacts the block and returns the new
+// length. Output is produced within the block that completes it, so a chain
+// never holds back more than the block it is given.
+class FilterStage
+{
+public:
+    virtual ~FilterStage() = default;
+
+    virtual size_t process(int64_t *timestampsUs, double *values, size_t count) = 0;
+    virtual void reset() = 0;
+    virtual QString describe() const = 0;
+
+    // Inputs per output
+    virtual size_t decimation() const { return 1; }
+
+    // New input rate for rate dependent stages, which keep their state.
+    // Fails, leaving the stage unchanged, if the stage cannot run at it.
+    virtual bool setSampleRate(double, QString *) { return true; }
+
+    // Standard deviation of each output of the last block, for stages that
+    // estimate one, otherwise nullptr
+    virtual const double *uncertainty() const { return nullptr; }
+};
+
+// Moving average over the last N samples
+class MovingAverageFilter : public FilterStage
+{
+public:
+    explicit MovingAverageFilter(size_t length);
+
+    size_t process(int64_t *timestampsUs, double *values, size_t count) override;
+    void reset() override;
+    QString describe() const override;
+
+private:
+    std::vector<double> window;
+    size_t head = 0;
+    size_t filled = 0;
+    double sum = 0.0;
+};
+
+// Running median over the last N samples (N odd), suppresses bus glitches
+class MedianFilter : public FilterStage
+{
+public:
+    explicit MedianFilter(size_t length);
+
+    size_t process(int64_t *timestampsUs, double *values, size_t count) override;
+    void reset() override;
+    QString describe() const override;
+
+private:
+    size_t length;
+    std::vector<double> window;     // arrival order
+    std::vector<double> sorted;
+    size_t head = 0;
+};
+
+// Second order Butterworth low-pass (transposed direct form II biquad)
+class LowPassFilter : public FilterStage
+{
+public:
+    LowPassFilter(double cutoffHz, double sampleRateHz);
+
+    size_t process(int64_t *timestampsUs, double *values, size_t count) override;
+    void reset() override;
+    QString describe() const override;
+    bool setSampleRate(double sampleRateHz, QString *error) override;
+
+private:
+    void design(double sampleRateHz);
+
+    double cutoffHz;
+    double b0, b1, b2, a1, a2;
+    double z1 = 0.0, z2 = 0.0;
+    bool primed = false;
+};
+
+// CIC decimator: 'order' cascaded boxcars of length R, one output per R
+// inputs. Order 1 is a plain boxcar average. Gain is normalised to 1.
+class DecimatorFilter : public FilterStage
+{
+public:
+    DecimatorFilter(size_t factor, size_t order = 1);
+
+    size_t process(int64_t *timestampsUs, double *values, size_t count) override;
+    void reset() override;
+    QString describe() const override;
+    size_t decimation() const override { return factor; }
+
+private:
+    size_t factor;
+    std::vector<MovingAverageFilter> smoothing;   // order - 1 stages
+    size_t phase = 0;
+    double sum = 0.0;
+};
+
+// Kalman estimator of the weight. The constant model tracks a value that
+// drifts as a random walk of 'processNoise' g/sqrt(s); the motion model
+// adds a velocity driven by white acceleration of 'processNoise'
+// g/s^2/sqrt(Hz). Measurements have 'measurementNoise' g standard
+// deviation. Time steps come from the sample timestamps.
+class KalmanFilter : public FilterStage
+{
+public:
+    enum Model { Constant, Motion };
+
+    KalmanFilter(double processNoise, double measurementNoise, Model model, double sampleRateHz);
+
+    size_t process(int64_t *timestampsUs, double *values, size_t count) override;
+    void reset() override;
+    QString describe() const override;
+    const double *uncertainty() const override { return sigma.data(); }
+    bool setSampleRate(double sampleRateHz, QString *error) override;
+
+private:
+    double q2;                  // process noise density, squared
+    double r2;                  // measurement variance
+    Model model;
+    double nominalDt;
+
+    bool primed = false;
+    int64_t lastUs = 0;
+    double x = 0.0, v = 0.0;
+    double pxx = 0.0, pxv = 0.0, pvv = 0.0;
+    std::vector<double> sigma;
+};
+
+// Ordered chain of stages, configured from a spec such as
+//   "median:5, movavg:16, lowpass:2, decimate:4:3, kalman:0.01:0.5"
+// An empty spec passes samples through unchanged.
+class FilterChain
+{
+public:
+    static bool parse(const QString &spec, double sampleRateHz, FilterChain &chain,
+                      QString *error = nullptr);
+
+    size_t process(int64_t *timestampsUs, double *values, size_t count);
+    void reset();
+
+    // Follows a change of the input rate without rebuilding the chain
+    bool setSampleRate(double sampleRateHz, QString *error = nullptr);
+
+    // Per output of the last block, when the final stage is an estimator
+    const double *uncertainty() const;
+
+    bool isEmpty() const { return stages.empty(); }
+    QString describe() const;
+    size_t decimation() const;
+
+private:
+    std::vector<std::unique_ptr<FilterStage>> stages;
+};
@@ -0,0 +1,155 @@
+#include "flightrecorder.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <algorithm>
+#include <csignal>
+#include <mutex>
+#include <vector>
+
+std::atomic<bool> FlightRecorder::enabled{false};
+
+namespace {
+
+constexpr size_t kRingSize = 1 << 15;   // spans per thread, ~1 MiB
+
+struct Span
+{
+    std::atomic<const char *> name;
+    std::atomic<int64_t> beginNs;
+    std::atomic<int64_t> endNs;
+    std::atomic<int64_t> arg;
+};
+
+struct ThreadRing
+{
+    int tid = 0;
+    std::atomic<const char *> threadName{nullptr};
+    std::atomic<uint64_t> head{0};
+    Span spans[kRingSize];
+};
+
+std::mutex registryMutex;
+std::vector<ThreadRing *> registry;     // never freed, threads are few
+
+thread_local ThreadRing *localRing = nullptr;
+
+volatile std::sig_atomic_t dumpRequested = 0;
+
+ThreadRing &ring()
+{
+    if (!localRing) {
+        localRing = new ThreadRing();
+        std::lock_guard<std::mutex> lock(registryMutex);
+        localRing->tid = int(registry.size()) + 1;
+        registry.push_back(localRing);
+    }
+    return *localRing;
+}
+
+void onDumpSignal(int sig)
+{
+    dumpRequested = 1;
+    std::signal(sig, onDumpSignal);
+}
+
+} // namespace
+
+void FlightRecorder::setThreadName(const char *name)
+{
+    ring().threadName.store(name, std::memory_order_relaxed);
+}
+
+void FlightRecorder::record(const char *name, int64_t beginNs, int64_t endNs, int64_t arg)
+{
+    ThreadRing &r = ring();
+    uint64_t head = r.head.load(std::memory_order_relaxed);
+
+    Span &s = r.spans[head & (kRingSize - 1)];
+    s.name.store(name, std::memory_order_relaxed);
+    s.beginNs.store(beginNs, std::memory_order_relaxed);
+    s.endNs.store(endNs, std::memory_order_relaxed);
+    s.arg.store(arg, std::memory_order_relaxed);
+
+    r.head.store(head + 1, std::memory_order_release);
+}
+
+bool FlightRecorder::dump(const QString &path, QString *error)
+{
+    QByteArray json;
+    json.reserve(1 << 20);
+    json += "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+
+    bool first = true;
+    auto separator = [&]() {
+        if (!first)
+            json += ",\n";
+        first = false;
+    };
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (ThreadRing *r : registry) {
+        if (const char *name = r->threadName.load(std::memory_order_relaxed)) {
+            separator();
+            json += "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":"
+                  + QByteArray::number(r->tid) + ",\"args\":{\"name\":\"" + name + "\"}}";
+        }
+
+        uint64_t head = r->head.load(std::memory_order_acquire);
+        uint64_t begin = head > kRingSize ? head - kRingSize : 0;
+
+        // Copy first, then drop what the writer may have overwritten meanwhile
+        struct Copy { const char *name; int64_t beginNs, endNs, arg; };
+        std::vector<Copy> copies;
+        copies.reserve(head - begin);
+        for (uint64_t i = begin; i < head; ++i) {
+            const Span &s = r->spans[i & (kRingSize - 1)];
+            copies.push_back({ s.name.load(std::memory_order_relaxed),
+                               s.beginNs.load(std::memory_order_relaxed),
+                               s.endNs.load(std::memory_order_relaxed),
+                               s.arg.load(std::memory_order_relaxed) });
+        }
+        // The writer may be inside slot headAfter, which shares its place
+        // with index headAfter - kRingSize; that one counts as overwritten too
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t headAfter = r->head.load(std::memory_order_relaxed);
+        size_t skip = headAfter + 1 > kRingSize + begin ? size_t(headAfter + 1 - kRingSize - begin) : 0;
+
+        for (size_t i = std::min(skip, copies.size()); i < copies.size(); ++i) {
+            const Copy &c = copies[i];
+            separator();
+            json += "{\"ph\":\"X\",\"cat\":\"pipeline\",\"pid\":1,\"tid\":" + QByteArray::number(r->tid)
+                  + ",\"name\":\"" + c.name
+                  + "\",\"ts\":" + QByteArray::number(c.beginNs / 1000.0, 'f', 3)
+                  + ",\"dur\":" + QByteArray::number((c.endNs - c.beginNs) / 1000.0, 'f', 3);
+            if (c.arg >= 0)
+                json += ",\"args\":{\"n\":" + QByteArray::number(qint64(c.arg)) + "}";
+            json += "}";
+        }
+    }
+    json += "\n]}\n";
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(json) != json.size()) {
+        if (error) *error = file.errorString();
+        return false;
+    }
+    return true;
+}
+
+void FlightRecorder::installSignalHandler()
+{
+#if defined(SIGUSR1)
+    std::signal(SIGUSR1, onDumpSignal);
+#elif defined(SIGBREAK)
+    std::signal(SIGBREAK, onDumpSignal);
+#endif
+}
+
+bool FlightRecorder::takeDumpRequest()
+{
+    if (!dumpRequested)
+        return false;
+    dumpRequested = 0;
+    return true;
+}
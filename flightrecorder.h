@@ -0,0 +1,56 @@
+#pragma once
+
+#include <QString>
+#include <atomic>
+#include <cstdint>
+
+#include "latencytrace.h"
+
+// Always-on timeline of pipeline activity. Spans go into a fixed-size ring
+// per thread and are dumped as Chrome trace JSON (chrome://tracing,
+// ui.perfetto.dev) on demand, so the last few seconds before a stall can
+// be inspected after the fact.
+class FlightRecorder
+{
+public:
+    static void setEnabled(bool on) { enabled.store(on, std::memory_order_relaxed); }
+    static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+    // Names the calling thread in the dump
+    static void setThreadName(const char *name);
+
+    // 'name' must be a string literal; arg < 0 means none
+    static void record(const char *name, int64_t beginNs, int64_t endNs, int64_t arg = -1);
+
+    static bool dump(const QString &path, QString *error = nullptr);
+
+    // Dump trigger from a signal handler (SIGUSR1, or Ctrl+Break on Windows)
+    static void installSignalHandler();
+    static bool takeDumpRequest();
+
+private:
+    static std::atomic<bool> enabled;
+};
+
+// Records the lifetime of the scope as one span
+class TraceSpan
+{
+public:
+    explicit TraceSpan(const char *name, int64_t arg = -1)
+        : name(name), arg(arg), beginNs(FlightRecorder::isEnabled() ? LatencyTrace::now() : 0)
+    {
+    }
+
+    ~TraceSpan()
+    {
+        if (beginNs)
+            FlightRecorder::record(name, beginNs, LatencyTrace::now(), arg);
+    }
+
+    void setArg(int64_t value) { arg = value; }
+
+private:
+    const char *name;
+    int64_t arg;
+    int64_t beginNs;
+};
@@ -1,4 +1,7 @@
 #include "ftdireader.h"
+#include "flightrecorder.h"
+#include "latencytrace.h"
+#include "pipelinemetrics.h"
 
 FtdiReader::FtdiReader(ftdi_context *ctx, QObject *parent)
     : QObject(parent), ftdi(ctx)
@@ -16,10 +19,20 @@ void FtdiReader::start()
 
     unsigned char buf[16384];
 
+    FlightRecorder::setThreadName("reader");
+
     while (running) {
+        qint64 startNs = LatencyTrace::now();
         int n = ftdi_read_data(ftdi, buf, sizeof(buf));
         if (n > 0) {
-            emit bytesReceived(QByteArray(reinterpret_cast<char*>(buf), n));
+            qint64 readNs = LatencyTrace::now();
+            if (FlightRecorder::isEnabled())
+                FlightRecorder::record("usb read", startNs, readNs, n);
+            PipelineMetrics::add(PipelineMetrics::UsbBytes, n);
+            PipelineMetrics::add(PipelineMetrics::UsbReads);
+            PipelineMetrics::add(PipelineMetrics::ChunksQueued);
+            emit bytesReceived(QByteArray(reinterpret_cast<char*>(buf), n), readNs);
+            LatencyTrace::record(LatencyTrace::Read, readNs);
         } else if (n < 0) {
             emit error("FTDI read error");
             break;
@@ -5,6 +5,9 @@
 #include <atomic>
 #include <ftdi.h>
 
+// Sniffer UART, 8N1
+constexpr int kSnifferBaudRate = 921600;
+
 class FtdiReader : public QObject
 {
     Q_OBJECT
@@ -17,7 +20,7 @@ public slots:
     void stop();
 
 signals:
-    void bytesReceived(QByteArray data);
+    void bytesReceived(QByteArray data, qint64 readNs);
     void error(QString msg);
 
 private:
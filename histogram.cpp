@@ -0,0 +1,195 @@
+#include "histogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Rescale decaying weights before they overflow
+constexpr double kMaxWeight = 1e100;
+
+// Decaying bins below this share of the total no longer hold the range
+constexpr double kNegligible = 1e-3;
+
+} // namespace
+
+WeightHistogram::WeightHistogram(const HistogramSettings &settings)
+{
+    configure(settings);
+}
+
+void WeightHistogram::configure(const HistogramSettings &settings)
+{
+    cfg = settings;
+    cfg.bins = std::max<size_t>((cfg.bins + 1) & ~size_t(1), 2);
+    cfg.resolution = cfg.resolution > 0.0 ? cfg.resolution : 1e-6;
+    cfg.windowSeconds = std::max(cfg.windowSeconds, 1.0);
+    reset();
+}
+
+void WeightHistogram::reset()
+{
+    haveRange = false;
+    total.assign(cfg.bins, 0.0);
+    totalCount = 0.0;
+    slices.clear();
+    sliceCounts.clear();
+    sliceUs = 0;
+    if (cfg.mode != HistogramSettings::Cumulative)
+        sliceUs = std::max<int64_t>(int64_t(cfg.windowSeconds * 1e6) / int64_t(kSlices), 1);
+    if (cfg.mode == HistogramSettings::Windowed) {
+        slices.assign(kSlices, std::vector<double>(cfg.bins, 0.0));
+        sliceCounts.assign(kSlices, 0.0);
+    }
+    currentSlice = 0;
+    decayOriginUs = 0;
+}
+
+void WeightHistogram::expandTo(double value)
+{
+    const size_t n = cfg.bins;
+    auto merge = [n](std::vector<double> &bins, bool intoUpperHalf) {
+        const size_t offset = intoUpperHalf ? n / 2 : 0;
+        std::vector<double> merged(n, 0.0);
+        for (size_t i = 0; i < n; ++i)
+            merged[offset + i / 2] += bins[i];
+        bins.swap(merged);
+    };
+
+    while (value < lo || value >= lo + width * double(n)) {
+        bool downwards = value < lo;
+        merge(total, downwards);
+        for (std::vector<double> &slice : slices)
+            merge(slice, downwards);
+        if (downwards)
+            lo -= width * double(n);
+        width *= 2.0;
+    }
+}
+
+void WeightHistogram::shrinkToFit()
+{
+    const size_t n = cfg.bins;
+    const double floor = cfg.mode == HistogramSettings::Decaying ? totalCount * kNegligible : 0.0;
+
+    for (;;) {
+        size_t first = n;
+        size_t last = 0;
+        for (size_t i = 0; i < n; ++i) {
+            if (total[i] > floor) {
+                first = std::min(first, i);
+                last = i;
+            }
+        }
+        if (first == n || last - first + 1 > n / 4 || width / 2.0 < cfg.resolution)
+            return;
+
+        // Halve the width around the live bins, centred, splitting each in two
+        const size_t offset = (n - 2 * (last - first + 1)) / 2;
+        auto split = [n, first, last, offset](std::vector<double> &bins) {
+            std::vector<double> halves(n, 0.0);
+            for (size_t i = first; i <= last; ++i) {
+                halves[offset + 2 * (i - first)] = bins[i] / 2.0;
+                halves[offset + 2 * (i - first) + 1] = bins[i] / 2.0;
+            }
+            bins.swap(halves);
+        };
+
+        // Negligible decaying weight outside the new range is dropped
+        for (size_t i = 0; i < n; ++i) {
+            if (i < first || i > last)
+                totalCount -= total[i];
+        }
+        split(total);
+        for (std::vector<double> &slice : slices)
+            split(slice);
+        lo += double(first) * width - double(offset) * width / 2.0;
+        width /= 2.0;
+    }
+}
+
+void WeightHistogram::retireSlices(int64_t timestampUs)
+{
+    const int64_t slice = timestampUs / sliceUs;
+    if (slice <= currentSlice)
+        return;
+
+    // Clear the slots between the old and the new current slice, at most
+    // all of them after a long gap
+    const int64_t steps = std::min<int64_t>(slice - currentSlice, int64_t(kSlices));
+    for (int64_t s = 1; s <= steps; ++s) {
+        size_t k = size_t((currentSlice + s) % int64_t(kSlices));
+        if (sliceCounts[k] == 0.0)
+            continue;
+        for (size_t i = 0; i < cfg.bins; ++i)
+            total[i] -= slices[k][i];
+        totalCount -= sliceCounts[k];
+        std::fill(slices[k].begin(), slices[k].end(), 0.0);
+        sliceCounts[k] = 0.0;
+    }
+    currentSlice = slice;
+    shrinkToFit();
+}
+
+void WeightHistogram::add(int64_t timestampUs, double value)
+{
+    if (!std::isfinite(value))
+        return;
+
+    if (!haveRange) {
+        width = cfg.resolution;
+        lo = (std::floor(value / width) - double(cfg.bins / 2)) * width;
+        haveRange = true;
+        currentSlice = sliceUs ? timestampUs / sliceUs : 0;
+        decayOriginUs = timestampUs;
+    }
+
+    // Age the bins first: shrinking may leave the value out of range
+    if (cfg.mode == HistogramSettings::Windowed) {
+        retireSlices(timestampUs);
+    }
+    else if (cfg.mode == HistogramSettings::Decaying && timestampUs / sliceUs > currentSlice) {
+        currentSlice = timestampUs / sliceUs;
+        shrinkToFit();
+    }
+    expandTo(value);
+
+    size_t bin = std::min(size_t((value - lo) / width), cfg.bins - 1);
+
+    double weight = 1.0;
+    if (cfg.mode == HistogramSettings::Decaying) {
+        const double tauUs = cfg.windowSeconds * 1e6;
+        weight = std::exp(double(timestampUs - decayOriginUs) / tauUs);
+        if (weight > kMaxWeight) {
+            for (double &c : total)
+                c /= weight;
+            totalCount /= weight;
+            decayOriginUs = timestampUs;
+            weight = 1.0;
+        }
+    }
+    else if (cfg.mode == HistogramSettings::Windowed) {
+        size_t k = size_t(currentSlice % int64_t(kSlices));
+        slices[k][bin] += 1.0;
+        sliceCounts[k] += 1.0;
+    }
+
+    total[bin] += weight;
+    totalCount += weight;
+}
+
+void WeightHistogram::snapshot(int64_t nowUs, HistogramSnapshot &out) const
+{
+    out.lo = lo;
+    out.width = width;
+    out.counts = total;
+    out.total = totalCount;
+
+    // Decaying counts are stored relative to the origin; bring them to 'now'
+    if (cfg.mode == HistogramSettings::Decaying && haveRange) {
+        double scale = std::exp(-double(nowUs - decayOriginUs) / (cfg.windowSeconds * 1e6));
+        for (double &c : out.counts)
+            c *= scale;
+        out.total *= scale;
+    }
+}
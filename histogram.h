@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct HistogramSettings
+{
+    enum Source : uint8_t { Readings, Items };
+    enum Mode : uint8_t
+    {
+        Cumulative,     // everything since the last reset
+        Windowed,       // the last 'windowSeconds'
+        Decaying        // weights fall off with time constant 'windowSeconds'
+    };
+
+    Source source = Readings;
+    Mode mode = Cumulative;
+    double windowSeconds = 300.0;
+    size_t bins = 64;               // even
+    double resolution = 0.001;      // initial bin width
+};
+
+// Bin counts handed to the GUI; bin i covers [lo + i*width, lo + (i+1)*width)
+struct HistogramSnapshot
+{
+    double lo = 0.0;
+    double width = 0.0;
+    double total = 0.0;
+    std::vector<double> counts;
+};
+
+// Fixed number of bins over a range that grows to fit the data: a value
+// outside it doubles the bin width, merging neighbouring bins, which only
+// happens O(log range) times. Adding a sample is O(1). The windowed mode
+// keeps kSlices sub-histograms and retires the oldest as time moves on;
+// the decaying mode scales each new sample up instead of all bins down.
+// In both, once per slice the range halves again while the live bins fit
+// in a quarter of it, so one outlier does not coarsen them for good; the
+// old counts are split evenly and are replaced by fine ones as they age.
+class WeightHistogram
+{
+public:
+    static constexpr size_t kSlices = 16;
+
+    explicit WeightHistogram(const HistogramSettings &settings = HistogramSettings());
+
+    void configure(const HistogramSettings &settings);
+    const HistogramSettings &settings() const { return cfg; }
+
+    void reset();
+    void add(int64_t timestampUs, double value);
+
+    bool isEmpty() const { return !haveRange; }
+    void snapshot(int64_t nowUs, HistogramSnapshot &out) const;
+
+private:
+    void expandTo(double value);
+    void retireSlices(int64_t timestampUs);
+    void shrinkToFit();
+
+    HistogramSettings cfg;
+
+    bool haveRange = false;
+    double lo = 0.0;
+    double width = 0.0;
+
+    // Cumulative and decaying: one set of bins. Windowed: 'total' is the
+    // sum of the slices, kept current as samples arrive and slices retire.
+    std::vector<double> total;
+    double totalCount = 0.0;
+    std::vector<std::vector<double>> slices;
+    std::vector<double> sliceCounts;
+    int64_t sliceUs = 0;            // also the shrink interval when decaying
+    int64_t currentSlice = 0;       // timestamp / sliceUs of the newest
+
+    // Decaying: samples are added with weight exp((t - decayOriginUs) / tau)
+    int64_t decayOriginUs = 0;
+};
@@ -0,0 +1,82 @@
+#include "histogramview.h"
+
+#include <QPainter>
+#include <algorithm>
+#include <cmath>
+
+HistogramView::HistogramView(QWidget *parent)
+    : QWidget(parent)
+{
+    setMinimumHeight(90);
+}
+
+void HistogramView::setSnapshot(const HistogramSnapshot &snapshot)
+{
+    snap = snapshot;
+    update();
+}
+
+void HistogramView::clear()
+{
+    snap = HistogramSnapshot();
+    update();
+}
+
+void HistogramView::paintEvent(QPaintEvent *)
+{
+    QPainter painter(this);
+    painter.fillRect(rect(), palette().base());
+
+    const QFontMetrics fm = painter.fontMetrics();
+    const QRect plot = rect().adjusted(4, fm.height() + 4, -4, -fm.height() - 4);
+
+    double peak = 0.0;
+    for (double c : snap.counts)
+        peak = std::max(peak, c);
+
+    painter.setPen(palette().color(QPalette::Text));
+    if (snap.counts.empty() || peak <= 0.0 || plot.height() < 2) {
+        painter.drawText(rect(), Qt::AlignCenter, "Histogram: waiting for samples");
+        return;
+    }
+
+    // Only the occupied bins are drawn, so a narrow distribution is not a
+    // single bar in a range that grew to fit an outlier
+    size_t first = 0;
+    size_t last = snap.counts.size() - 1;
+    while (snap.counts[first] <= 0.0)
+        first++;
+    while (snap.counts[last] <= 0.0)
+        last--;
+
+    double sum = 0.0;
+    double sumSq = 0.0;
+    double weight = 0.0;
+    for (size_t i = first; i <= last; ++i) {
+        double x = snap.lo + (double(i) + 0.5) * snap.width;
+        sum += snap.counts[i] * x;
+        sumSq += snap.counts[i] * x * x;
+        weight += snap.counts[i];
+    }
+    const double mean = sum / weight;
+    const double sd = std::sqrt(std::max(sumSq / weight - mean * mean, 0.0));
+
+    painter.drawText(QRect(plot.left(), 2, plot.width(), fm.height()), Qt::AlignLeft,
+                     QString("n %1, mean %2, sd %3").arg(snap.total, 0, 'f', 0)
+                         .arg(mean, 0, 'f', 3).arg(sd, 0, 'f', 3));
+    painter.drawText(QRect(plot.left(), plot.bottom() + 2, plot.width(), fm.height()), Qt::AlignLeft,
+                     QString::number(snap.lo + double(first) * snap.width, 'f', 3));
+    painter.drawText(QRect(plot.left(), plot.bottom() + 2, plot.width(), fm.height()), Qt::AlignRight,
+                     QString::number(snap.lo + double(last + 1) * snap.width, 'f', 3));
+    painter.drawText(QRect(plot.left(), plot.bottom() + 2, plot.width(), fm.height()), Qt::AlignHCenter,
+                     QString("bin %1").arg(snap.width, 0, 'g', 3));
+
+    const size_t shown = last - first + 1;
+    const double barWidth = double(plot.width()) / double(shown);
+    const QColor barColor = palette().color(QPalette::Highlight);
+    for (size_t i = first; i <= last; ++i) {
+        double h = snap.counts[i] / peak * plot.height();
+        painter.fillRect(QRectF(plot.left() + double(i - first) * barWidth, plot.bottom() - h,
+                                std::max(barWidth - 1.0, 1.0), h), barColor);
+    }
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <QWidget>
+
+#include "histogram.h"
+
+// Bar plot of a HistogramSnapshot with its range, count, mean and sd
+class HistogramView : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit HistogramView(QWidget *parent = nullptr);
+
+    void setSnapshot(const HistogramSnapshot &snapshot);
+    void clear();
+
+    QSize sizeHint() const override { return QSize(300, 140); }
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    HistogramSnapshot snap;
+};
@@ -0,0 +1,134 @@
+#include "i2cdecoder.h"
+
+namespace {
+
+constexpr std::string_view kWritePrefix = "[2AWA";
+constexpr std::string_view kReadMarker = "[2AR";
+
+bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+}
+
+int hexDigit(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+} // namespace
+
+std::string_view trimLine(std::string_view line)
+{
+    while (!line.empty() && isSpace(line.front()))
+        line.remove_prefix(1);
+    while (!line.empty() && isSpace(line.back()))
+        line.remove_suffix(1);
+    return line;
+}
+
+void formatTransaction(const I2cTransaction &txn, char *out)
+{
+    static const char digits[] = "0123456789ABCDEF";
+    std::memcpy(out, "[2AWA00A[2ARA00]", kTransactionLineLength);
+    out[5] = digits[txn.reg >> 4];
+    out[6] = digits[txn.reg & 0xF];
+    out[13] = digits[txn.value >> 4];
+    out[14] = digits[txn.value & 0xF];
+}
+
+LineKind parseTransaction(std::string_view line, I2cTransaction &txn)
+{
+    if (line.substr(0, kWritePrefix.size()) != kWritePrefix)
+        return LineKind::Ignored;
+
+    size_t rIndex = line.find(kReadMarker);
+    if (rIndex == std::string_view::npos || rIndex + 5 >= line.size())
+        return LineKind::Malformed;
+
+    // Data byte; a single trailing digit is accepted like QString::toUInt()
+    int hi = hexDigit(line[rIndex + 5]);
+    if (hi < 0)
+        return LineKind::Malformed;
+    int value = hi;
+    if (rIndex + 6 < line.size()) {
+        int lo = hexDigit(line[rIndex + 6]);
+        if (lo < 0)
+            return LineKind::Malformed;
+        value = (hi << 4) | lo;
+    }
+
+    // Register, only meaningful when followed by its ACK
+    int regHi = line.size() > 7 ? hexDigit(line[5]) : -1;
+    int regLo = line.size() > 7 ? hexDigit(line[6]) : -1;
+    if (regHi >= 0 && regLo >= 0 && line[7] == 'A')
+        txn.reg = static_cast<uint8_t>((regHi << 4) | regLo);
+    else
+        txn.reg = 0xFF;
+
+    txn.value = static_cast<uint8_t>(value);
+    return LineKind::Transaction;
+}
+
+bool parseRegisterWrite(std::string_view line, I2cTransaction &txn)
+{
+    if (line.size() < 10 || line.substr(0, kWritePrefix.size()) != kWritePrefix)
+        return false;
+    if (line.find(kReadMarker) != std::string_view::npos)
+        return false;
+
+    int regHi = hexDigit(line[5]);
+    int regLo = hexDigit(line[6]);
+    int hi = hexDigit(line[8]);
+    int lo = hexDigit(line[9]);
+    if (regHi < 0 || regLo < 0 || line[7] != 'A' || hi < 0 || lo < 0)
+        return false;
+    if (line.size() > 10 && line[10] != 'A')
+        return false;
+
+    txn.reg = static_cast<uint8_t>((regHi << 4) | regLo);
+    txn.value = static_cast<uint8_t>((hi << 4) | lo);
+    return true;
+}
+
+TripletAssembler::State TripletAssembler::next(State state, const I2cTransaction *txn)
+{
+    if (!txn)
+        return Expect12;
+    if (state == Expect12 && txn->reg == 0x12)
+        return Expect13;
+    if (state == Expect13 && txn->reg == 0x13)
+        return Expect14;
+    return Expect12;
+}
+
+bool TripletAssembler::push(const I2cTransaction &txn, int64_t timestampUs, AdcSample &out)
+{
+    if (st == Expect12 && txn.reg == 0x12) {
+        bytes[0] = txn.value;
+        tripletTimestamp = timestampUs;
+        st = Expect13;
+    }
+    else if (st == Expect13 && txn.reg == 0x13) {
+        bytes[1] = txn.value;
+        st = Expect14;
+    }
+    else if (st == Expect14 && txn.reg == 0x14) {
+        bytes[2] = txn.value;
+
+        out.timestampUs = tripletTimestamp;
+        out.code = (uint32_t(bytes[0]) << 16) |
+                   (uint32_t(bytes[1]) << 8) |
+                    uint32_t(bytes[2]);
+
+        st = Expect12;
+        return true;
+    }
+    else {
+        st = Expect12;
+    }
+
+    return false;
+}
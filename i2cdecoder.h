@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+// Sniffer line layout for a NAU7802 register read (device address 0x2A):
+//   [2AWA12A[2ARA5F...
+//    |  | | |  | ||
+//    |  | | |  | |+- data byte (hex)
+//    |  | | |  | +-- ACK
+//    |  | | |  +---- repeated start, read
+//    |  | | +------- ACK
+//    |  | +--------- register (hex)
+//    |  +----------- ACK
+//    +-------------- address 0x2A, write
+//
+// A register write has the data byte straight after the register:
+//   [2AWA02AA7A]
+
+// One NAU7802 conversion assembled from the 0x12/0x13/0x14 reads
+struct AdcSample
+{
+    int64_t timestampUs;    // capture time, us since epoch (0 if unknown)
+    uint32_t code;          // raw 24-bit ADC code
+};
+
+struct I2cTransaction
+{
+    uint8_t reg;
+    uint8_t value;
+};
+
+enum class LineKind
+{
+    Ignored,        // not a [2AWA line
+    Malformed,      // [2AWA line without a readable data byte
+    Transaction
+};
+
+// Strips leading/trailing whitespace (CR, spaces) like QString::trimmed()
+std::string_view trimLine(std::string_view line);
+
+// Decodes one trimmed sniffer line
+LineKind parseTransaction(std::string_view line, I2cTransaction &txn);
+
+// Decodes a register write, register and data byte both ACKed with no
+// repeated start; parseTransaction() reports these lines as Malformed
+bool parseRegisterWrite(std::string_view line, I2cTransaction &txn);
+
+// Writes the usual layout of a register read, "[2AWA12A[2ARA5F]", so lines
+// in that layout can be stored as a transaction and rendered again
+constexpr size_t kTransactionLineLength = 16;
+void formatTransaction(const I2cTransaction &txn, char *out);
+
+// Calls onLine(std::string_view) for every '\n' terminated line in the
+// buffer and returns the number of bytes consumed (up to the last '\n').
+template <typename F>
+size_t forEachLine(const char *data, size_t len, F &&onLine)
+{
+    const char *begin = data;
+    const char *end = data + len;
+
+    while (begin < end) {
+        const char *nl = static_cast<const char *>(std::memchr(begin, '\n', end - begin));
+        if (!nl)
+            break;
+        onLine(std::string_view(begin, nl - begin));
+        begin = nl + 1;
+    }
+
+    return begin - data;
+}
+
+// Splits a byte stream into lines, carrying partial lines across reads
+class LineSplitter
+{
+public:
+    template <typename F>
+    void feed(const char *data, size_t len, F &&onLine)
+    {
+        if (!pending.empty()) {
+            const char *nl = static_cast<const char *>(std::memchr(data, '\n', len));
+            if (!nl) {
+                pending.append(data, len);
+                return;
+            }
+            size_t head = nl - data;
+            pending.append(data, head);
+            onLine(std::string_view(pending));
+            pending.clear();
+            data += head + 1;
+            len -= head + 1;
+        }
+
+        size_t used = forEachLine(data, len, onLine);
+        pending.assign(data + used, len - used);
+    }
+
+    void clear() { pending.clear(); }
+    size_t pendingBytes() const { return pending.size(); }
+
+private:
+    std::string pending;
+};
+
+// Collects the 0x12, 0x13, 0x14 reads of one conversion. Any out of order
+// or malformed transaction drops the partial triplet.
+class TripletAssembler
+{
+public:
+    enum State : uint8_t { Expect12, Expect13, Expect14 };
+
+    // State transition only, used to resynchronise split decodes
+    static State next(State state, const I2cTransaction *txn);
+
+    // Returns true and fills 'out' when a triplet completes
+    bool push(const I2cTransaction &txn, int64_t timestampUs, AdcSample &out);
+    void reset() { st = Expect12; }
+
+    State state() const { return st; }
+
+private:
+    State st = Expect12;
+    uint8_t bytes[3] = {};
+    int64_t tripletTimestamp = 0;
+};
@@ -0,0 +1,133 @@
+#include "latencytrace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+// 8 linear sub-buckets per power of two, about 6% resolution
+constexpr int kSubBits = 3;
+constexpr int kSubBuckets = 1 << kSubBits;
+constexpr int kBuckets = 64 * kSubBuckets;
+
+struct ThreadHistograms
+{
+    std::atomic<uint64_t> counts[LatencyTrace::StageCount][kBuckets];
+    std::atomic<int64_t> maxNs[LatencyTrace::StageCount];
+};
+
+std::mutex registryMutex;
+std::vector<ThreadHistograms *> registry;   // never freed, threads are few
+
+thread_local ThreadHistograms *localHistograms = nullptr;
+
+ThreadHistograms &histograms()
+{
+    if (!localHistograms) {
+        localHistograms = new ThreadHistograms();
+        std::lock_guard<std::mutex> lock(registryMutex);
+        registry.push_back(localHistograms);
+    }
+    return *localHistograms;
+}
+
+int bucketOf(uint64_t ns)
+{
+    if (ns < kSubBuckets)
+        return int(ns);
+    int msb = std::bit_width(ns) - 1;
+    int sub = int(ns >> (msb - kSubBits)) & (kSubBuckets - 1);
+    return (msb - kSubBits + 1) * kSubBuckets + sub;
+}
+
+// Midpoint of the bucket's value range
+int64_t bucketValue(int bucket)
+{
+    if (bucket < kSubBuckets)
+        return bucket;
+    int shift = bucket / kSubBuckets - 1;
+    int64_t lower = int64_t(kSubBuckets + bucket % kSubBuckets) << shift;
+    return lower + (int64_t(1) << shift) / 2;
+}
+
+} // namespace
+
+void LatencyTrace::record(Stage stage, int64_t originNs, int64_t nowNs)
+{
+    ThreadHistograms &h = histograms();
+    int64_t ns = nowNs > originNs ? nowNs - originNs : 0;
+
+    // Only the owning thread writes, so plain load/store is enough
+    std::atomic<uint64_t> &count = h.counts[stage][bucketOf(uint64_t(ns))];
+    count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    if (ns > h.maxNs[stage].load(std::memory_order_relaxed))
+        h.maxNs[stage].store(ns, std::memory_order_relaxed);
+}
+
+std::array<LatencyTrace::Summary, LatencyTrace::StageCount> LatencyTrace::summarize()
+{
+    std::array<Summary, StageCount> result;
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (int stage = 0; stage < StageCount; ++stage) {
+        std::vector<uint64_t> merged(kBuckets, 0);
+        Summary &s = result[stage];
+
+        for (ThreadHistograms *h : registry) {
+            for (int b = 0; b < kBuckets; ++b)
+                merged[b] += h->counts[stage][b].load(std::memory_order_relaxed);
+            s.maxNs = std::max(s.maxNs, h->maxNs[stage].load(std::memory_order_relaxed));
+        }
+
+        for (uint64_t c : merged)
+            s.count += c;
+        if (s.count == 0)
+            continue;
+
+        uint64_t p50 = (s.count + 1) / 2;
+        uint64_t p99 = s.count - s.count / 100;
+        uint64_t seen = 0;
+        for (int b = 0; b < kBuckets; ++b) {
+            if (!merged[b])
+                continue;
+            uint64_t before = seen;
+            seen += merged[b];
+            if (before < p50 && seen >= p50)
+                s.p50Ns = bucketValue(b);
+            if (before < p99 && seen >= p99) {
+                s.p99Ns = bucketValue(b);
+                break;
+            }
+        }
+    }
+    return result;
+}
+
+void LatencyTrace::reset()
+{
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (ThreadHistograms *h : registry) {
+        for (int stage = 0; stage < StageCount; ++stage) {
+            for (int b = 0; b < kBuckets; ++b)
+                h->counts[stage][b].store(0, std::memory_order_relaxed);
+            h->maxNs[stage].store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+const char *LatencyTrace::stageName(Stage stage)
+{
+    switch (stage) {
+    case Read:    return "read";
+    case Split:   return "split";
+    case Decode:  return "decode";
+    case Convert: return "convert";
+    case Queued:  return "queued to GUI";
+    case Painted: return "painted";
+    default:      return "?";
+    }
+}
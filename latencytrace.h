@@ -0,0 +1,37 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+// End-to-end latency of the acquisition pipeline. Each stage records the
+// time elapsed since the USB read that delivered its data into a log-linear
+// histogram owned by the calling thread, so recording is a clock read and a
+// couple of relaxed stores. Summaries merge all threads on demand.
+class LatencyTrace
+{
+public:
+    enum Stage { Read, Split, Decode, Convert, Queued, Painted, StageCount };
+
+    struct Summary
+    {
+        uint64_t count = 0;
+        int64_t p50Ns = 0;
+        int64_t p99Ns = 0;
+        int64_t maxNs = 0;
+    };
+
+    static int64_t now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    static void record(Stage stage, int64_t originNs) { record(stage, originNs, now()); }
+    static void record(Stage stage, int64_t originNs, int64_t nowNs);
+
+    static std::array<Summary, StageCount> summarize();
+    static void reset();
+
+    static const char *stageName(Stage stage);
+};
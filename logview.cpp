@@ -0,0 +1,246 @@
+#include "logview.h"
+
+#include <QFontDatabase>
+#include <QScrollBar>
+#include <algorithm>
+
+#include "adcconvert.h"
+
+ValueLogModel::ValueLogModel(Format format, size_t maxRows, QObject *parent)
+    : QAbstractListModel(parent),
+      format(format),
+      maxRows(maxRows)
+{
+}
+
+void ValueLogModel::append(int64_t timestampUs, double value, double sigma)
+{
+    rows.push_back({ timestampUs, value, sigma });
+    staged++;
+}
+
+void ValueLogModel::flush()
+{
+    if (!staged)
+        return;
+
+    const int announced = int(rows.size() - staged);
+    beginInsertRows(QModelIndex(), announced, int(rows.size()) - 1);
+    staged = 0;
+    endInsertRows();
+
+    // Trim in chunks of a tenth so views relayout rarely
+    if (rows.size() > maxRows + maxRows / 10) {
+        const size_t excess = rows.size() - maxRows;
+        beginRemoveRows(QModelIndex(), 0, int(excess) - 1);
+        for (size_t i = 0; i < excess; ++i)
+            rows.pop_front();
+        endRemoveRows();
+    }
+}
+
+int ValueLogModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : int(rows.size() - staged);
+}
+
+QVariant ValueLogModel::data(const QModelIndex &index, int role) const
+{
+    if (role != Qt::DisplayRole || !index.isValid() || index.row() >= rowCount())
+        return QVariant();
+
+    const Row &row = rows[size_t(index.row())];
+
+    // "[hh:mm:ss.zzz] value" or "[hh:mm:ss.zzz] value ± sigma"
+    char buf[kTimestampLength + 2 * kMaxNumber + 8];
+    char *p = buf;
+    *p++ = '[';
+    p = timestamps.format(p, row.timestampUs / 1000);
+    *p++ = ']';
+    *p++ = ' ';
+    if (format == Integer) {
+        p = formatInt(p, int64_t(row.value));
+    }
+    else {
+        p = formatFixed(p, row.value, 3);
+        if (row.sigma >= 0.0) {
+            *p++ = ' ';
+            *p++ = char(0xB1);      // Latin-1 plus-minus
+            *p++ = ' ';
+            p = formatFixed(p, row.sigma, 3);
+        }
+    }
+    return QString::fromLatin1(buf, p - buf);
+}
+
+StoreLogModel::StoreLogModel(const SampleStore *store, Column column, size_t maxRows,
+                             QObject *parent)
+    : QAbstractListModel(parent),
+      store(store),
+      column(column),
+      maxRows(maxRows),
+      version(store->calibration().version)
+{
+    firstIndex = endIndex = store->endIndex();
+}
+
+void StoreLogModel::sync()
+{
+    // Evicted from the store
+    const uint64_t begin = std::min(store->beginIndex(), endIndex);
+    if (begin > firstIndex) {
+        beginRemoveRows(QModelIndex(), 0, int(begin - firstIndex) - 1);
+        firstIndex = begin;
+        endRemoveRows();
+    }
+
+    const uint64_t end = store->endIndex();
+    if (end > endIndex) {
+        beginInsertRows(QModelIndex(), int(endIndex - firstIndex), int(end - firstIndex) - 1);
+        endIndex = end;
+        endInsertRows();
+    }
+
+    // Trim in chunks of a tenth so views relayout rarely
+    if (endIndex - firstIndex > maxRows + maxRows / 10) {
+        const uint64_t excess = endIndex - firstIndex - maxRows;
+        beginRemoveRows(QModelIndex(), 0, int(excess) - 1);
+        firstIndex += excess;
+        endRemoveRows();
+    }
+
+    if (column != Extracted && store->calibration().version != version && rowCount())
+        emit dataChanged(index(0), index(rowCount() - 1), { Qt::DisplayRole });
+    version = store->calibration().version;
+}
+
+int StoreLogModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : int(endIndex - firstIndex);
+}
+
+QVariant StoreLogModel::data(const QModelIndex &index, int role) const
+{
+    if (role != Qt::DisplayRole || !index.isValid() || index.row() >= rowCount())
+        return QVariant();
+
+    const uint64_t i = firstIndex + uint64_t(index.row());
+    if (i < store->beginIndex() || i >= store->endIndex())
+        return QVariant();
+
+    // "[hh:mm:ss.zzz] value"
+    char buf[kTimestampLength + kMaxNumber + 4];
+    char *p = buf;
+    *p++ = '[';
+    p = timestamps.format(p, store->timestampAt(i) / 1000);
+    *p++ = ']';
+    *p++ = ' ';
+    switch (column) {
+    case Extracted:
+        p = formatInt(p, int64_t(signExtend24(store->codeAt(i))) * 1000);
+        break;
+    case Tared:
+        p = formatInt(p, store->taredAt(i));
+        break;
+    case Scaled:
+        p = formatFixed(p, store->scaledAt(i), 3);
+        break;
+    }
+    return QString::fromLatin1(buf, p - buf);
+}
+
+RawLogModel::RawLogModel(size_t maxRows, size_t maxTexts, QObject *parent)
+    : QAbstractListModel(parent),
+      maxRows(maxRows),
+      maxTexts(maxTexts)
+{
+}
+
+void RawLogModel::append(int64_t timestampUs, const I2cTransaction &txn, const QByteArray &text)
+{
+    Row row{ timestampUs, 0, txn, !text.isEmpty() };
+    if (row.hasText) {
+        row.text = nextText++;
+        texts.push_back(text);
+        if (texts.size() > maxTexts) {
+            texts.pop_front();
+            firstText++;
+        }
+    }
+    rows.push_back(row);
+    staged++;
+}
+
+void RawLogModel::flush()
+{
+    if (!staged)
+        return;
+
+    const int announced = int(rows.size() - staged);
+    beginInsertRows(QModelIndex(), announced, int(rows.size()) - 1);
+    staged = 0;
+    endInsertRows();
+
+    if (rows.size() > maxRows + maxRows / 10) {
+        const size_t excess = rows.size() - maxRows;
+        beginRemoveRows(QModelIndex(), 0, int(excess) - 1);
+        for (size_t i = 0; i < excess; ++i)
+            rows.pop_front();
+        endRemoveRows();
+    }
+}
+
+int RawLogModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : int(rows.size() - staged);
+}
+
+QVariant RawLogModel::data(const QModelIndex &index, int role) const
+{
+    if (role != Qt::DisplayRole || !index.isValid() || index.row() >= rowCount())
+        return QVariant();
+
+    const Row &row = rows[size_t(index.row())];
+
+    char buf[kTimestampLength + kTransactionLineLength + 4];
+    char *p = buf;
+    *p++ = '[';
+    p = timestamps.format(p, row.timestampUs / 1000);
+    *p++ = ']';
+    *p++ = ' ';
+
+    if (!row.hasText) {
+        formatTransaction(row.txn, p);
+        p += kTransactionLineLength;
+        return QString::fromLatin1(buf, p - buf);
+    }
+
+    // Position in the text ring; unsigned wrap-around keeps it valid
+    const uint32_t position = row.text - firstText;
+    if (position >= texts.size())
+        return QString::fromLatin1(buf, p - buf) + "(text no longer kept)";
+    return QString::fromLatin1(buf, p - buf) + QString::fromUtf8(texts[position]);
+}
+
+LogView::LogView(QWidget *parent)
+    : QListView(parent)
+{
+    setUniformItemSizes(true);
+    setEditTriggers(QAbstractItemView::NoEditTriggers);
+    setSelectionMode(QAbstractItemView::ExtendedSelection);
+    setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+}
+
+void LogView::setModel(QAbstractItemModel *model)
+{
+    QListView::setModel(model);
+
+    connect(model, &QAbstractItemModel::rowsAboutToBeInserted, this, [this]() {
+        QScrollBar *bar = verticalScrollBar();
+        following = bar->value() == bar->maximum();
+    });
+    connect(model, &QAbstractItemModel::rowsInserted, this, [this]() {
+        if (following)
+            scrollToBottom();
+    });
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <QAbstractListModel>
+#include <QByteArray>
+#include <QListView>
+#include <cstddef>
+#include <cstdint>
+
+#include "i2cdecoder.h"
+#include "ringdeque.h"
+#include "samplestore.h"
+#include "textformat.h"
+
+// Timestamped values for a log column, kept as 24-byte rows in a bounded
+// ring. Text is produced in data(), i.e. only for the rows a view paints.
+class ValueLogModel : public QAbstractListModel
+{
+    Q_OBJECT
+public:
+    enum Format { Integer, Fixed3 };
+
+    ValueLogModel(Format format, size_t maxRows, QObject *parent = nullptr);
+
+    // Rows are staged and reach views together on flush()
+    void append(int64_t timestampUs, double value, double sigma = -1.0);
+    void flush();
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+private:
+    struct Row
+    {
+        int64_t timestampUs;
+        double value;
+        double sigma;       // shown as +/- when >= 0
+    };
+
+    Format format;
+    size_t maxRows;
+    RingDeque<Row> rows;
+    size_t staged = 0;      // rows at the back not yet announced to views
+    mutable TimestampFormatter timestamps;
+};
+
+// A column of the sample history, read from the store by index: rows hold
+// nothing, so a calibration change re-renders every row on screen with the
+// store's recomputed tared and scaled values. Shows the newest maxRows
+// samples the store still holds.
+class StoreLogModel : public QAbstractListModel
+{
+    Q_OBJECT
+public:
+    enum Column { Extracted, Tared, Scaled };
+
+    StoreLogModel(const SampleStore *store, Column column, size_t maxRows, QObject *parent = nullptr);
+
+    // Announces samples appended to the store since the last call, drops
+    // evicted ones and refreshes all rows after a calibration change
+    void sync();
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+private:
+    const SampleStore *store;
+    Column column;
+    size_t maxRows;
+    uint64_t firstIndex = 0;    // store index of row 0
+    uint64_t endIndex = 0;      // store index after the last row
+    uint32_t version = 0;       // calibration the rows were shown with
+    mutable TimestampFormatter timestamps;
+};
+
+// Sniffer lines as 16-byte records: timestamp and transaction, rendered
+// back to "[2AWA12A[2ARA5F]" for display. Lines in any other layout keep
+// their text in a separate, smaller ring; once it has been recycled the
+// row says so.
+class RawLogModel : public QAbstractListModel
+{
+    Q_OBJECT
+public:
+    RawLogModel(size_t maxRows, size_t maxTexts, QObject *parent = nullptr);
+
+    // 'text' is empty for lines in the usual layout
+    void append(int64_t timestampUs, const I2cTransaction &txn, const QByteArray &text);
+    void flush();
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+private:
+    struct Row
+    {
+        int64_t timestampUs;
+        uint32_t text;          // sequence number in 'texts' if hasText
+        I2cTransaction txn;
+        bool hasText;
+    };
+
+    size_t maxRows;
+    size_t maxTexts;
+    RingDeque<Row> rows;
+    RingDeque<QByteArray> texts;
+    uint32_t firstText = 0;     // sequence number of texts.front()
+    uint32_t nextText = 0;
+    size_t staged = 0;
+    mutable TimestampFormatter timestamps;
+};
+
+// Read-only list for a log model that keeps following new rows while it is
+// scrolled to the bottom, like QTextEdit::append
+class LogView : public QListView
+{
+    Q_OBJECT
+public:
+    explicit LogView(QWidget *parent = nullptr);
+
+    void setModel(QAbstractItemModel *model) override;
+
+private:
+    bool following = true;
+};
@@ -1,8 +1,16 @@
 #include "mainwindow.h"
+#include "offlinedecoder.h"
 #include <QApplication>
+#include <cstring>
 
 int main(int argc, char *argv[])
 {
+    // Headless offline decode of a raw capture
+    if (argc > 1 && std::strcmp(argv[1], "--decode") == 0) {
+        QCoreApplication a(argc, argv);
+        return runOfflineDecode(a.arguments());
+    }
+
     QApplication a(argc, argv);
     MainWindow w;
     w.show();
@@ -6,52 +6,453 @@
 #include <QLabel>
 #include <QScreen>
 #include <QGuiApplication>
+#include <QFontDatabase>
+#include <QAbstractEventDispatcher>
+#include <QStatusBar>
+#include <QFileDialog>
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#include "adcconvert.h"
+#include "csvexport.h"
+#include "flightrecorder.h"
+#include "latencytrace.h"
+#include "pipelinemetrics.h"
+#include "sampledecoder.h"
+
+namespace {
+
+// Trigger captures kept for inspection and export
+constexpr int kMaxCaptures = 32;
+
+// Rows kept by each value log (24 bytes each)
+constexpr size_t kMaxLogRows = 1000000;
+
+// Raw transactions (16 bytes each) and lines kept as text
+constexpr size_t kMaxRawRows = 4000000;
+constexpr size_t kMaxRawTexts = 100000;
+
+} // namespace
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent),
-      readingEnabled(false),
-      scalingFactor(399835),
-      tareValue(2625000),
       ftdi(nullptr),
       readerThread(nullptr),
-      reader(nullptr)
+      reader(nullptr),
+      decoderThread(nullptr),
+      decoder(nullptr),
+      spectrumThread(nullptr),
+      spectrumAnalyzer(nullptr),
+      secondRollups(24 * 3600),
+      minuteRollups(7 * 24 * 60),
+      spectrumNext(0),
+      spectrumBusy(false),
+      spectrumGeneration(0),
+      paintOriginNs(0),
+      awakeNs(0)
 {
-    rawEdit = new QTextEdit(this);
-    extractedEdit = new QTextEdit(this);
-    taredEdit = new QTextEdit(this);
-    scalingEdit = new QTextEdit(this);
+    rawEdit = new LogView(this);
+    extractedEdit = new LogView(this);
+    taredEdit = new LogView(this);
+    scalingEdit = new LogView(this);
+    filteredEdit = new LogView(this);
     statusEdit = new QTextEdit(this);
 
-    rawEdit->setReadOnly(true);
-    extractedEdit->setReadOnly(true);
-    taredEdit->setReadOnly(true);
-    scalingEdit->setReadOnly(true);
+    rawLog = new RawLogModel(kMaxRawRows, kMaxRawTexts, this);
+    extractedLog = new StoreLogModel(&store, StoreLogModel::Extracted, kMaxLogRows, this);
+    taredLog = new StoreLogModel(&store, StoreLogModel::Tared, kMaxLogRows, this);
+    scaledLog = new StoreLogModel(&store, StoreLogModel::Scaled, kMaxLogRows, this);
+    filteredLog = new ValueLogModel(ValueLogModel::Fixed3, kMaxLogRows, this);
+    rawEdit->setModel(rawLog);
+    extractedEdit->setModel(extractedLog);
+    taredEdit->setModel(taredLog);
+    scalingEdit->setModel(scaledLog);
+    filteredEdit->setModel(filteredLog);
+
     statusEdit->setReadOnly(true);
+    statusEdit->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
 
     startStopButton = new QPushButton("Start", this);
     startStopButton->setCheckable(true);
 
     connect(startStopButton, &QPushButton::toggled, this, [this](bool checked) {
-        readingEnabled = checked;
+        decoder->setEnabled(checked);
         startStopButton->setText(checked ? "Stop" : "Start");
     });
 
+    traceButton = new QPushButton("Flight Recorder", this);
+    traceButton->setCheckable(true);
+    dumpTraceButton = new QPushButton("Dump Trace", this);
+
+    connect(traceButton, &QPushButton::toggled, this, [](bool checked) {
+        FlightRecorder::setEnabled(checked);
+    });
+    connect(dumpTraceButton, &QPushButton::clicked, this, &MainWindow::dumpTrace);
+
+    exportButton = new QPushButton("Export CSV...", this);
+    connect(exportButton, &QPushButton::clicked, this, &MainWindow::exportSamples);
+
     tareButton = new QPushButton("Set Tare:", this);
-    tareInput = new QLineEdit(QString::number(tareValue), this);
+    tareInput = new QLineEdit(QString::number(calibrations.current()->tareValue), this);
 
     connect(tareButton, &QPushButton::clicked, this, [this]() {
         bool ok;
-        int v = tareInput->text().toInt(&ok);
-        if (ok) tareValue = v;
+        qint64 v = tareInput->text().toLongLong(&ok);
+        if (ok && v >= -kTareLimit && v <= kTareLimit) {
+            applyCalibration(*calibrations.publishTare(v, "tare"));
+            tareInput->setModified(false);
+        }
+        else {
+            statusBar()->showMessage(QString("Tare must be an integer within +-%1").arg(kTareLimit), 5000);
+        }
     });
 
-    scalingFactorInput = new QLineEdit(QString::number(scalingFactor), this);
+    scalingFactorInput = new QLineEdit(QString::number(calibrations.current()->scalingFactor), this);
     scalingFactorButton = new QPushButton("Apply", this);
 
     connect(scalingFactorButton, &QPushButton::clicked, this, [this]() {
         bool ok;
         int v = scalingFactorInput->text().toInt(&ok);
-        if (ok && v != 0) scalingFactor = v;
+        if (ok && v != 0)
+            applyCalibration(*calibrations.publishScaling(v, "scaling"));
+    });
+
+    statsSamplesInput = new QSpinBox(this);
+    statsSamplesInput->setRange(2, 1000000);
+    statsSamplesInput->setValue(320);
+    statsSamplesInput->setSuffix(" samples");
+    statsSecondsInput = new QDoubleSpinBox(this);
+    statsSecondsInput->setRange(0.1, 3600.0);
+    statsSecondsInput->setValue(10.0);
+    statsSecondsInput->setSuffix(" s");
+
+    statsLabel = new QLabel(this);
+    statsLabel->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    statsLabel->setTextInteractionFlags(Qt::TextSelectableByMouse);
+
+    auto applyStatsWindows = [this]() {
+        int samples = statsSamplesInput->value();
+        double seconds = statsSecondsInput->value();
+        QMetaObject::invokeMethod(decoder, [this, samples, seconds]() {
+            decoder->setStatsWindows(samples, seconds);
+        });
+    };
+    connect(statsSamplesInput, &QSpinBox::valueChanged, this, applyStatsWindows);
+    connect(statsSecondsInput, &QDoubleSpinBox::valueChanged, this, applyStatsWindows);
+
+    filterInput = new QLineEdit(this);
+    filterInput->setPlaceholderText("e.g. median:5, movavg:16, lowpass:2, decimate:4");
+    filterInput->setToolTip("Weight filter chain, applied in order:\n"
+                            "  movavg:N       moving average over N samples\n"
+                            "  median:N       running median over N samples\n"
+                            "  lowpass:Hz     2nd order Butterworth low-pass\n"
+                            "  decimate:R[:K] CIC decimator by R, order K (boxcar for K = 1)");
+
+    connect(filterInput, &QLineEdit::returnPressed, this, [this]() {
+        QString spec = filterInput->text();
+        QMetaObject::invokeMethod(decoder, [this, spec]() { decoder->setFilter(spec); });
+    });
+
+    StabilityParameters stableDefaults;
+    stableWindowInput = new QSpinBox(this);
+    stableWindowInput->setRange(2, 10000);
+    stableWindowInput->setValue(int(stableDefaults.window));
+    stableWindowInput->setSuffix(" samples");
+    stableStddevInput = new QDoubleSpinBox(this);
+    stableStddevInput->setDecimals(4);
+    stableStddevInput->setRange(0.0001, 1e6);
+    stableStddevInput->setValue(stableDefaults.maxStddev);
+    stableSlopeInput = new QDoubleSpinBox(this);
+    stableSlopeInput->setDecimals(4);
+    stableSlopeInput->setRange(0.0001, 1e6);
+    stableSlopeInput->setValue(stableDefaults.maxSlope);
+    stableSlopeInput->setSuffix(" /s");
+
+    stabilityLabel = new QLabel("MOTION", this);
+    stabilityLabel->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+
+    eventLog = new QTextEdit(this);
+    eventLog->setReadOnly(true);
+    eventLog->setMaximumHeight(90);
+    eventLog->document()->setMaximumBlockCount(1000);
+
+    auto applyStability = [this]() {
+        StabilityParameters params;
+        params.window = size_t(stableWindowInput->value());
+        params.maxStddev = stableStddevInput->value();
+        params.maxSlope = stableSlopeInput->value();
+        QMetaObject::invokeMethod(decoder, [this, params]() {
+            decoder->setStabilityParameters(params);
+        });
+    };
+    connect(stableWindowInput, &QSpinBox::valueChanged, this, applyStability);
+    connect(stableStddevInput, &QDoubleSpinBox::valueChanged, this, applyStability);
+    connect(stableSlopeInput, &QDoubleSpinBox::valueChanged, this, applyStability);
+
+    triggerTypeInput = new QComboBox(this);
+    triggerTypeInput->addItem("Trigger off", TriggerSettings::Off);
+    triggerTypeInput->addItem("Level", TriggerSettings::Level);
+    triggerTypeInput->addItem("Slope [/s]", TriggerSettings::Slope);
+    triggerTypeInput->addItem("Step", TriggerSettings::Step);
+    triggerTypeInput->addItem("Stable -> motion", TriggerSettings::Motion);
+    triggerEdgeInput = new QComboBox(this);
+    triggerEdgeInput->addItem("Rising", TriggerSettings::Rising);
+    triggerEdgeInput->addItem("Falling", TriggerSettings::Falling);
+    triggerEdgeInput->addItem("Either", TriggerSettings::Either);
+    triggerThresholdInput = new QDoubleSpinBox(this);
+    triggerThresholdInput->setDecimals(3);
+    triggerThresholdInput->setRange(-1e9, 1e9);
+    triggerStepInput = new QSpinBox(this);
+    triggerStepInput->setRange(1, 1000);
+    triggerStepInput->setValue(4);
+    triggerStepInput->setPrefix("step N ");
+    triggerPreInput = new QSpinBox(this);
+    triggerPreInput->setRange(0, 100000);
+    triggerPreInput->setValue(100);
+    triggerPreInput->setPrefix("pre ");
+    triggerPostInput = new QSpinBox(this);
+    triggerPostInput->setRange(0, 100000);
+    triggerPostInput->setValue(100);
+    triggerPostInput->setPrefix("post ");
+    triggerSingleInput = new QCheckBox("Single", this);
+    triggerArmButton = new QPushButton("Arm", this);
+    captureSelect = new QComboBox(this);
+    captureSelect->setMinimumContentsLength(28);
+    exportCaptureButton = new QPushButton("Export Capture...", this);
+
+    auto applyTrigger = [this]() {
+        TriggerSettings settings;
+        settings.type = TriggerSettings::Type(triggerTypeInput->currentData().toInt());
+        settings.edge = TriggerSettings::Edge(triggerEdgeInput->currentData().toInt());
+        settings.threshold = triggerThresholdInput->value();
+        settings.stepWindow = size_t(triggerStepInput->value());
+        settings.preSamples = size_t(triggerPreInput->value());
+        settings.postSamples = size_t(triggerPostInput->value());
+        settings.singleShot = triggerSingleInput->isChecked();
+        QMetaObject::invokeMethod(decoder, [this, settings]() {
+            decoder->configureTrigger(settings);
+        });
+    };
+    connect(triggerTypeInput, &QComboBox::currentIndexChanged, this, applyTrigger);
+    connect(triggerEdgeInput, &QComboBox::currentIndexChanged, this, applyTrigger);
+    connect(triggerThresholdInput, &QDoubleSpinBox::valueChanged, this, applyTrigger);
+    connect(triggerStepInput, &QSpinBox::valueChanged, this, applyTrigger);
+    connect(triggerPreInput, &QSpinBox::valueChanged, this, applyTrigger);
+    connect(triggerPostInput, &QSpinBox::valueChanged, this, applyTrigger);
+    connect(triggerSingleInput, &QCheckBox::toggled, this, applyTrigger);
+    connect(triggerArmButton, &QPushButton::clicked, this, [this]() {
+        QMetaObject::invokeMethod(decoder, [this]() { decoder->armTrigger(); });
+    });
+    connect(exportCaptureButton, &QPushButton::clicked, this, &MainWindow::exportCapture);
+
+    AutoZeroSettings zeroDefaults;
+    autoZeroInput = new QCheckBox("Auto-zero", this);
+    auto zeroSpin = [this](double value, const QString &prefix, const QString &suffix) {
+        QDoubleSpinBox *spin = new QDoubleSpinBox(this);
+        spin->setDecimals(3);
+        spin->setRange(0.001, 1e6);
+        spin->setValue(value);
+        spin->setPrefix(prefix);
+        spin->setSuffix(suffix);
+        return spin;
+    };
+    autoZeroBandInput = zeroSpin(zeroDefaults.zeroBand, "zero band +/- ", "");
+    autoZeroStableInput = zeroSpin(zeroDefaults.stableBand, "still p-p ", "");
+    autoZeroRateInput = zeroSpin(zeroDefaults.maxRate, "rate ", " /s");
+    autoZeroLimitInput = zeroSpin(zeroDefaults.maxTotal, "limit +/- ", "");
+
+    auto applyAutoZero = [this]() {
+        AutoZeroSettings settings;
+        settings.enabled = autoZeroInput->isChecked();
+        settings.zeroBand = autoZeroBandInput->value();
+        settings.stableBand = autoZeroStableInput->value();
+        settings.maxRate = autoZeroRateInput->value();
+        settings.maxTotal = autoZeroLimitInput->value();
+        QMetaObject::invokeMethod(decoder, [this, settings]() {
+            decoder->configureAutoZero(settings);
+        });
+    };
+    connect(autoZeroInput, &QCheckBox::toggled, this, applyAutoZero);
+    connect(autoZeroBandInput, &QDoubleSpinBox::valueChanged, this, applyAutoZero);
+    connect(autoZeroStableInput, &QDoubleSpinBox::valueChanged, this, applyAutoZero);
+    connect(autoZeroRateInput, &QDoubleSpinBox::valueChanged, this, applyAutoZero);
+    connect(autoZeroLimitInput, &QDoubleSpinBox::valueChanged, this, applyAutoZero);
+
+    CheckweigherSettings weighDefaults;
+    checkweighInput = new QCheckBox("Checkweigher", this);
+    auto weighSpin = [this](double value, const QString &prefix) {
+        QDoubleSpinBox *spin = new QDoubleSpinBox(this);
+        spin->setDecimals(3);
+        spin->setRange(0.0, 1e6);
+        spin->setValue(value);
+        spin->setPrefix(prefix);
+        return spin;
+    };
+    checkweighLoadInput = weighSpin(weighDefaults.loadThreshold, "load > ");
+    checkweighUnloadInput = weighSpin(weighDefaults.unloadThreshold, "unload < ");
+    checkweighBandInput = weighSpin(weighDefaults.settleBand, "settled p-p ");
+    checkweighSettleInput = new QSpinBox(this);
+    checkweighSettleInput->setRange(1, 1000);
+    checkweighSettleInput->setValue(int(weighDefaults.settleSamples));
+    checkweighSettleInput->setPrefix("over ");
+    checkweighSettleInput->setSuffix(" samples");
+    checkweighLowerInput = weighSpin(weighDefaults.lowerLimit, "min ");
+    checkweighLowerInput->setSpecialValueText("no min");
+    checkweighUpperInput = weighSpin(weighDefaults.upperLimit, "max ");
+    checkweighUpperInput->setSpecialValueText("no max");
+    checkweighBatchButton = new QPushButton("New Batch", this);
+    checkweighLabel = new QLabel(this);
+    checkweighLabel->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+
+    auto applyCheckweigher = [this]() {
+        CheckweigherSettings settings;
+        settings.enabled = checkweighInput->isChecked();
+        settings.loadThreshold = checkweighLoadInput->value();
+        settings.unloadThreshold = checkweighUnloadInput->value();
+        settings.settleBand = checkweighBandInput->value();
+        settings.settleSamples = size_t(checkweighSettleInput->value());
+        settings.lowerLimit = checkweighLowerInput->value();
+        settings.upperLimit = checkweighUpperInput->value();
+        QMetaObject::invokeMethod(decoder, [this, settings]() {
+            decoder->configureCheckweigher(settings);
+        });
+    };
+    connect(checkweighInput, &QCheckBox::toggled, this, applyCheckweigher);
+    connect(checkweighLoadInput, &QDoubleSpinBox::valueChanged, this, applyCheckweigher);
+    connect(checkweighUnloadInput, &QDoubleSpinBox::valueChanged, this, applyCheckweigher);
+    connect(checkweighBandInput, &QDoubleSpinBox::valueChanged, this, applyCheckweigher);
+    connect(checkweighSettleInput, &QSpinBox::valueChanged, this, applyCheckweigher);
+    connect(checkweighLowerInput, &QDoubleSpinBox::valueChanged, this, applyCheckweigher);
+    connect(checkweighUpperInput, &QDoubleSpinBox::valueChanged, this, applyCheckweigher);
+    connect(checkweighBatchButton, &QPushButton::clicked, this, [this]() {
+        QMetaObject::invokeMethod(decoder, [this]() { decoder->newCheckweighBatch(); });
+        checkweighLabel->clear();
+        // A new batch may be a new product: its SPC baseline starts over
+        applySpcSettings();
+    });
+
+    referenceWeightInput = new QDoubleSpinBox(this);
+    referenceWeightInput->setDecimals(3);
+    referenceWeightInput->setRange(-1e9, 1e9);
+    referenceWeightInput->setPrefix("reference ");
+    addPointButton = new QPushButton("Add Point", this);
+    addPointButton->setToolTip("Records the reference weight against the mean raw code of the\n"
+                               "\"last N\" statistics window");
+    clearPointsButton = new QPushButton("Clear Points", this);
+    curveKindInput = new QComboBox(this);
+    curveKindInput->addItem("Linear fit", 1);
+    curveKindInput->addItem("Quadratic fit", 2);
+    curveKindInput->addItem("Piecewise linear", 0);
+    fitCurveButton = new QPushButton("Fit && Apply", this);
+    pointsLabel = new QLabel("0 points", this);
+
+    connect(addPointButton, &QPushButton::clicked, this, &MainWindow::addCalibrationPoint);
+    connect(clearPointsButton, &QPushButton::clicked, this, [this]() {
+        calibrationPoints.clear();
+        pointsLabel->setText("0 points");
+    });
+    connect(fitCurveButton, &QPushButton::clicked, this, &MainWindow::fitCalibration);
+
+    exportRollupsButton = new QPushButton("Export Rollups...", this);
+    connect(exportRollupsButton, &QPushButton::clicked, this, &MainWindow::exportRollups);
+
+    rollupPortInput = new QSpinBox(this);
+    rollupPortInput->setRange(1, 65535);
+    rollupPortInput->setValue(5025);
+    rollupPortInput->setPrefix("port ");
+    rollupRemoteInput = new QCheckBox("all interfaces", this);
+    rollupRemoteInput->setToolTip("Accept clients from the network, not only from this machine");
+    rollupServeButton = new QPushButton("Serve Rollups", this);
+    rollupServeButton->setCheckable(true);
+
+    connect(rollupServeButton, &QPushButton::toggled, this, [this](bool checked) {
+        if (!checked) {
+            rollupServer.close();
+            rollupPortInput->setEnabled(true);
+            rollupRemoteInput->setEnabled(true);
+            return;
+        }
+        QHostAddress address = rollupRemoteInput->isChecked() ? QHostAddress(QHostAddress::Any)
+                                                              : QHostAddress(QHostAddress::LocalHost);
+        QString error;
+        if (!rollupServer.listen(quint16(rollupPortInput->value()), address, &error)) {
+            statusBar()->showMessage("Rollup server: " + error, 5000);
+            rollupServeButton->setChecked(false);
+            return;
+        }
+        rollupPortInput->setEnabled(false);
+        rollupRemoteInput->setEnabled(false);
+        statusBar()->showMessage(QString("Serving rollups on %1:%2")
+                                     .arg(address.toString())
+                                     .arg(rollupPortInput->value()), 5000);
+    });
+
+    spectrumView = new SpectrumView(this);
+    spectrumLengthInput = new QComboBox(this);
+    for (int length = 256; length <= 8192; length *= 2)
+        spectrumLengthInput->addItem(QString("FFT %1").arg(length), length);
+    spectrumLengthInput->setCurrentIndex(spectrumLengthInput->findData(1024));
+    spectrumResetButton = new QPushButton("Reset Spectrum", this);
+
+    connect(spectrumLengthInput, &QComboBox::currentIndexChanged, this, &MainWindow::restartSpectrum);
+    connect(spectrumResetButton, &QPushButton::clicked, this, &MainWindow::restartSpectrum);
+
+    SpcSettings spcDefaults;
+    spcSubgroupInput = new QSpinBox(this);
+    spcSubgroupInput->setRange(2, 10);
+    spcSubgroupInput->setValue(int(spcDefaults.subgroupSize));
+    spcSubgroupInput->setPrefix("subgroups of ");
+    spcBaselineInput = new QSpinBox(this);
+    spcBaselineInput->setRange(2, 1000);
+    spcBaselineInput->setValue(int(spcDefaults.baselineSubgroups));
+    spcBaselineInput->setPrefix("limits from ");
+    spcBaselineInput->setSuffix(" subgroups");
+    spcUnsettledInput = new QCheckBox("incl. unsettled", this);
+    spcUnsettledInput->setToolTip("Also chart items weighed before they settled");
+    spcResetButton = new QPushButton("Reset SPC", this);
+    spcLabel = new QLabel("collecting baseline", this);
+    spcLabel->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    spcView = new SpcView(&spc, this);
+
+    connect(spcSubgroupInput, &QSpinBox::valueChanged, this, &MainWindow::applySpcSettings);
+    connect(spcBaselineInput, &QSpinBox::valueChanged, this, &MainWindow::applySpcSettings);
+    connect(spcUnsettledInput, &QCheckBox::toggled, this, &MainWindow::applySpcSettings);
+    connect(spcResetButton, &QPushButton::clicked, this, &MainWindow::applySpcSettings);
+
+    HistogramSettings histogramDefaults;
+    histogramSourceInput = new QComboBox(this);
+    histogramSourceInput->addItem("Histogram of readings", int(HistogramSettings::Readings));
+    histogramSourceInput->addItem("Histogram of items", int(HistogramSettings::Items));
+    histogramModeInput = new QComboBox(this);
+    histogramModeInput->addItem("since reset", int(HistogramSettings::Cumulative));
+    histogramModeInput->addItem("last", int(HistogramSettings::Windowed));
+    histogramModeInput->addItem("decaying over", int(HistogramSettings::Decaying));
+    histogramWindowInput = new QDoubleSpinBox(this);
+    histogramWindowInput->setRange(0.1, 1440.0);
+    histogramWindowInput->setValue(histogramDefaults.windowSeconds / 60.0);
+    histogramWindowInput->setSuffix(" min");
+    histogramWindowInput->setEnabled(false);
+    histogramResetButton = new QPushButton("Reset Histogram", this);
+    histogramView = new HistogramView(this);
+
+    auto applyHistogram = [this]() {
+        HistogramSettings settings;
+        settings.source = HistogramSettings::Source(histogramSourceInput->currentData().toInt());
+        settings.mode = HistogramSettings::Mode(histogramModeInput->currentData().toInt());
+        settings.windowSeconds = histogramWindowInput->value() * 60.0;
+        histogramWindowInput->setEnabled(settings.mode != HistogramSettings::Cumulative);
+        histogramView->clear();
+        QMetaObject::invokeMethod(decoder, [this, settings]() {
+            decoder->configureHistogram(settings);
+        });
+    };
+    connect(histogramSourceInput, &QComboBox::currentIndexChanged, this, applyHistogram);
+    connect(histogramModeInput, &QComboBox::currentIndexChanged, this, applyHistogram);
+    connect(histogramWindowInput, &QDoubleSpinBox::valueChanged, this, applyHistogram);
+    connect(histogramResetButton, &QPushButton::clicked, this, [this]() {
+        histogramView->clear();
+        QMetaObject::invokeMethod(decoder, [this]() { decoder->resetHistogram(); });
     });
 
     QHBoxLayout *controls = new QHBoxLayout();
@@ -61,31 +462,194 @@ MainWindow::MainWindow(QWidget *parent)
     controls->addWidget(new QLabel("Scaling:"));
     controls->addWidget(scalingFactorInput);
     controls->addWidget(scalingFactorButton);
+    controls->addWidget(exportButton);
+    controls->addWidget(exportRollupsButton);
+    controls->addWidget(rollupPortInput);
+    controls->addWidget(rollupRemoteInput);
+    controls->addWidget(rollupServeButton);
+    controls->addWidget(traceButton);
+    controls->addWidget(dumpTraceButton);
 
     QHBoxLayout *top = new QHBoxLayout();
     top->addWidget(rawEdit);
     top->addWidget(extractedEdit);
     top->addWidget(taredEdit);
     top->addWidget(scalingEdit);
+    top->addWidget(filteredEdit);
     top->addWidget(statusEdit);
 
+    QHBoxLayout *analysis = new QHBoxLayout();
+    analysis->addWidget(new QLabel("Statistics over:"));
+    analysis->addWidget(statsSamplesInput);
+    analysis->addWidget(statsSecondsInput);
+    analysis->addWidget(statsLabel, 1);
+    analysis->addWidget(new QLabel("Filter:"));
+    analysis->addWidget(filterInput);
+    analysis->addWidget(spectrumLengthInput);
+    analysis->addWidget(spectrumResetButton);
+
+    QHBoxLayout *detection = new QHBoxLayout();
+    detection->addWidget(new QLabel("Stable over:"));
+    detection->addWidget(stableWindowInput);
+    detection->addWidget(new QLabel("sd <="));
+    detection->addWidget(stableStddevInput);
+    detection->addWidget(new QLabel("slope <="));
+    detection->addWidget(stableSlopeInput);
+    detection->addWidget(stabilityLabel, 1);
+    detection->addWidget(autoZeroInput);
+    detection->addWidget(autoZeroBandInput);
+    detection->addWidget(autoZeroStableInput);
+    detection->addWidget(autoZeroRateInput);
+    detection->addWidget(autoZeroLimitInput);
+
+    QHBoxLayout *triggering = new QHBoxLayout();
+    triggering->addWidget(triggerTypeInput);
+    triggering->addWidget(triggerEdgeInput);
+    triggering->addWidget(triggerThresholdInput);
+    triggering->addWidget(triggerStepInput);
+    triggering->addWidget(triggerPreInput);
+    triggering->addWidget(triggerPostInput);
+    triggering->addWidget(triggerSingleInput);
+    triggering->addWidget(triggerArmButton);
+    triggering->addStretch(1);
+    triggering->addWidget(captureSelect);
+    triggering->addWidget(exportCaptureButton);
+
+    QHBoxLayout *multiPoint = new QHBoxLayout();
+    multiPoint->addWidget(new QLabel("Multi-point calibration:"));
+    multiPoint->addWidget(referenceWeightInput);
+    multiPoint->addWidget(addPointButton);
+    multiPoint->addWidget(clearPointsButton);
+    multiPoint->addWidget(pointsLabel);
+    multiPoint->addWidget(curveKindInput);
+    multiPoint->addWidget(fitCurveButton);
+    multiPoint->addStretch(1);
+
+    QHBoxLayout *checkweighing = new QHBoxLayout();
+    checkweighing->addWidget(checkweighInput);
+    checkweighing->addWidget(checkweighLoadInput);
+    checkweighing->addWidget(checkweighUnloadInput);
+    checkweighing->addWidget(checkweighBandInput);
+    checkweighing->addWidget(checkweighSettleInput);
+    checkweighing->addWidget(checkweighLowerInput);
+    checkweighing->addWidget(checkweighUpperInput);
+    checkweighing->addWidget(checkweighBatchButton);
+    checkweighing->addWidget(checkweighLabel, 1);
+
+    QHBoxLayout *spcControls = new QHBoxLayout();
+    spcControls->addWidget(new QLabel("SPC of item weights:"));
+    spcControls->addWidget(spcSubgroupInput);
+    spcControls->addWidget(spcBaselineInput);
+    spcControls->addWidget(spcUnsettledInput);
+    spcControls->addWidget(spcResetButton);
+    spcControls->addWidget(spcLabel, 1);
+    spcControls->addWidget(histogramSourceInput);
+    spcControls->addWidget(histogramModeInput);
+    spcControls->addWidget(histogramWindowInput);
+    spcControls->addWidget(histogramResetButton);
+
     QVBoxLayout *main = new QVBoxLayout();
     main->addLayout(top);
+    main->addLayout(analysis);
+    main->addLayout(detection);
+    main->addLayout(triggering);
+    main->addLayout(multiPoint);
+    main->addLayout(checkweighing);
+    main->addLayout(spcControls);
+    QHBoxLayout *lower = new QHBoxLayout();
+    lower->addWidget(eventLog, 1);
+    lower->addWidget(spectrumView, 1);
+    lower->addWidget(spcView, 1);
+    lower->addWidget(histogramView, 1);
+
+    main->addLayout(lower);
     main->addLayout(controls);
 
     QWidget *central = new QWidget(this);
     central->setLayout(main);
     setCentralWidget(central);
 
+    scalingEdit->viewport()->installEventFilter(this);
+
+    // GUI frames: one event loop pass each
+    FlightRecorder::setThreadName("gui");
+    FlightRecorder::installSignalHandler();
+
+    QAbstractEventDispatcher *dispatcher = QAbstractEventDispatcher::instance();
+    connect(dispatcher, &QAbstractEventDispatcher::awake, this, [this]() {
+        awakeNs = LatencyTrace::now();
+    });
+    connect(dispatcher, &QAbstractEventDispatcher::aboutToBlock, this, [this]() {
+        if (!awakeNs)
+            return;
+        qint64 endNs = LatencyTrace::now();
+        PipelineMetrics::add(PipelineMetrics::GuiFrames);
+        PipelineMetrics::add(PipelineMetrics::GuiFrameNs, endNs - awakeNs);
+        PipelineMetrics::raiseMaxFrameNs(endNs - awakeNs);
+        if (FlightRecorder::isEnabled() && endNs - awakeNs >= 20000)
+            FlightRecorder::record("gui frame", awakeNs, endNs);
+        awakeNs = 0;
+    });
+
+    lastMetrics = PipelineMetrics::snapshot();
+    lastMetricsTimer.start();
+
+    statusTimer = new QTimer(this);
+    connect(statusTimer, &QTimer::timeout, this, &MainWindow::updateStatus);
+    statusTimer->start(1000);
+
     resize(1200, 600);
     move(QGuiApplication::primaryScreen()->geometry().center() - rect().center());
 
+    // ---- Decoder thread ----
+    qRegisterMetaType<DecodedBatch>();
+    qRegisterMetaType<TriggerCapture>();
+
+    decoderThread = new QThread(this);
+    decoder = new SampleDecoder(&calibrations);
+
+    decoder->moveToThread(decoderThread);
+
+    connect(decoderThread, &QThread::finished, decoder, &QObject::deleteLater);
+    connect(decoder, &SampleDecoder::batchReady, this, &MainWindow::onBatch);
+    connect(decoder, &SampleDecoder::filterChanged, this,
+            [this](const QString &description, const QString &error) {
+        if (error.isEmpty())
+            statusBar()->showMessage("Filter: " + description, 5000);
+        else
+            statusBar()->showMessage("Filter not changed: " + error, 5000);
+    });
+    connect(decoder, &SampleDecoder::filterSuspended, this, [this](const QString &error) {
+        statusBar()->showMessage("Filter bypassed: " + error);
+    });
+
+    decoderThread->start();
+
+    // ---- Spectrum thread ----
+    qRegisterMetaType<Spectrum>();
+
+    spectrumThread = new QThread(this);
+    spectrumAnalyzer = new SpectrumAnalyzer();
+
+    spectrumAnalyzer->moveToThread(spectrumThread);
+
+    connect(spectrumThread, &QThread::finished, spectrumAnalyzer, &QObject::deleteLater);
+    connect(spectrumAnalyzer, &SpectrumAnalyzer::spectrumReady, this, [this](const Spectrum &spectrum) {
+        spectrumBusy = false;
+        if (spectrum.generation == spectrumGeneration)
+            spectrumView->setSpectrum(spectrum);
+    });
+
+    spectrumThread->start();
+
     // ---- FTDI init ----
     ftdi = ftdi_new();
     if (!ftdi) return;
 
     if (ftdi_usb_open(ftdi, 0x0403, 0x6001) < 0) return;
-    ftdi_set_baudrate(ftdi, 921600);
+    ftdi_set_baudrate(ftdi, kSnifferBaudRate);
+    // Deliver bytes within 1 ms so the decoder can timestamp lines accurately
+    ftdi_set_latency_timer(ftdi, 1);
 
     readerThread = new QThread(this);
     reader = new FtdiReader(ftdi);
@@ -95,7 +659,7 @@ MainWindow::MainWindow(QWidget *parent)
     connect(readerThread, &QThread::started, reader, &FtdiReader::start);
     connect(readerThread, &QThread::finished, reader, &QObject::deleteLater);
     connect(this, &MainWindow::destroyed, reader, &FtdiReader::stop);
-    connect(reader, &FtdiReader::bytesReceived, this, &MainWindow::onFtdiBytes);
+    connect(reader, &FtdiReader::bytesReceived, decoder, &SampleDecoder::onBytes);
 
     readerThread->start();
 }
@@ -108,83 +672,517 @@ MainWindow::~MainWindow()
         readerThread->wait();
     }
 
+    decoderThread->quit();
+    decoderThread->wait();
+
+    spectrumThread->quit();
+    spectrumThread->wait();
+
     if (ftdi) {
         ftdi_usb_close(ftdi);
         ftdi_free(ftdi);
     }
 }
 
-void MainWindow::onFtdiBytes(const QByteArray &data)
+bool MainWindow::eventFilter(QObject *watched, QEvent *event)
 {
-    if (!readingEnabled)
-        return;
+    if (event->type() == QEvent::Paint && paintOriginNs && watched == scalingEdit->viewport()) {
+        LatencyTrace::record(LatencyTrace::Painted, paintOriginNs);
+        paintOriginNs = 0;
+    }
+    return QMainWindow::eventFilter(watched, event);
+}
+
+void MainWindow::updateStatus()
+{
+    PipelineMetrics::Snapshot now = PipelineMetrics::snapshot();
+    double seconds = std::max<qint64>(lastMetricsTimer.restart(), 1) / 1000.0;
+    auto delta = [&](PipelineMetrics::Counter c) { return double(now[c] - lastMetrics[c]); };
+    auto rate = [&](PipelineMetrics::Counter c) { return delta(c) / seconds; };
 
-    rxBuffer.append(data);
+    double frames = delta(PipelineMetrics::GuiFrames);
+    double frameAvgMs = frames ? delta(PipelineMetrics::GuiFrameNs) / frames / 1e6 : 0.0;
 
-    int idx;
-    while ((idx = rxBuffer.indexOf('\n')) != -1) {
-        QByteArray line = rxBuffer.left(idx);
-        rxBuffer.remove(0, idx + 1);
-        processLine(line);
+    QString text;
+    text += QString("USB          %1 kB/s (%2 reads/s)\n")
+        .arg(rate(PipelineMetrics::UsbBytes) / 1000.0, 0, 'f', 1)
+        .arg(rate(PipelineMetrics::UsbReads), 0, 'f', 0);
+    text += QString("Lines        %1 /s\n").arg(rate(PipelineMetrics::Lines), 0, 'f', 0);
+    text += QString("ADC samples  %1 /s\n").arg(rate(PipelineMetrics::Samples), 0, 'f', 1);
+    text += QString("Queues       %1 reads to decoder, %2 batches to GUI\n")
+        .arg(now[PipelineMetrics::ChunksQueued] - now[PipelineMetrics::ChunksHandled])
+        .arg(now[PipelineMetrics::BatchesQueued] - now[PipelineMetrics::BatchesHandled]);
+    text += QString("Malformed    %1 lines (%2 total)\n")
+        .arg(delta(PipelineMetrics::MalformedLines), 0, 'f', 0)
+        .arg(now[PipelineMetrics::MalformedLines]);
+    text += QString("Dropped      %1 B while stopped\n").arg(now[PipelineMetrics::DroppedBytes]);
+    text += QString("Decoder CPU  %1 %\n")
+        .arg(delta(PipelineMetrics::DecoderNs) / (seconds * 1e7), 0, 'f', 1);
+    text += QString("GUI frames   %1 /s, avg %2 ms, max %3 ms\n")
+        .arg(frames / seconds, 0, 'f', 0)
+        .arg(frameAvgMs, 0, 'f', 2)
+        .arg(PipelineMetrics::takeMaxFrameNs() / 1e6, 0, 'f', 2);
+    text += QString("Memory       %1 MiB\n")
+        .arg(PipelineMetrics::processMemoryBytes() / (1024.0 * 1024.0), 0, 'f', 1);
+
+    const Calibration *calibration = calibrations.current();
+    QString curve;
+    switch (calibration->curve.kind) {
+    case CalibrationCurve::Scale:
+        curve = QString("scaling %1").arg(calibration->scalingFactor);
+        break;
+    case CalibrationCurve::Polynomial:
+        curve = QString("curve %1 + %2 t + %3 t^2")
+            .arg(calibration->curve.c[0], 0, 'g', 6)
+            .arg(calibration->curve.c[1], 0, 'g', 6)
+            .arg(calibration->curve.c[2], 0, 'g', 6);
+        break;
+    case CalibrationCurve::Piecewise:
+        curve = QString("piecewise, %1 points").arg(calibration->curve.x.size());
+        break;
+    }
+    text += QString("Calibration  v%1 (%2): tare %3, %4\n")
+        .arg(calibration->version)
+        .arg(QString::fromStdString(calibration->reason))
+        .arg(calibration->tareValue)
+        .arg(curve);
+
+    // History summaries from the store's pyramid, O(log n) each
+    const int64_t nowUs = QDateTime::currentMSecsSinceEpoch() * 1000;
+    auto toScaled = [calibration](double code) {
+        return scaledValue(int64_t(std::llround(code * 1000.0)) - calibration->tareValue, *calibration);
+    };
+    auto history = [&](const char *label, int64_t seconds) {
+        SampleStore::Summary h = store.summarizeTime(nowUs - seconds * 1000000, nowUs + 1);
+        if (h.count == 0)
+            return;
+        double lo = toScaled(h.min);
+        double hi = toScaled(h.max);
+        text += QString("Last %1 %2 samples, mean %3, min %4, max %5\n")
+            .arg(QString::fromLatin1(label), -6)
+            .arg(h.count)
+            .arg(toScaled(h.mean()), 0, 'f', 3)
+            .arg(std::min(lo, hi), 0, 'f', 3)
+            .arg(std::max(lo, hi), 0, 'f', 3);
+    };
+    history("1 min", 60);
+    history("1 h", 3600);
+
+    lastMetrics = now;
+
+    const AdcTimingSnapshot &t = latestTiming;
+    text += QString("\nADC timing   %1 SPS, interval mean %2 ms, jitter %3 ms\n"
+                    "             %4 intervals, %5 missed, %6 duplicate\n")
+        .arg(t.rateHz, 0, 'f', 0)
+        .arg(t.meanUs / 1000.0, 0, 'f', 3)
+        .arg(t.jitterUs / 1000.0, 0, 'f', 3)
+        .arg(t.intervals)
+        .arg(t.missed)
+        .arg(t.duplicates);
+
+    // Interval histogram in quarter periods, empty rows skipped
+    constexpr int kBinsPerRow = 4;
+    constexpr int kRows = AdcTimingSnapshot::kBins / kBinsPerRow;
+    std::array<uint64_t, kRows> rows{};
+    uint64_t rowMax = 0;
+    for (int i = 0; i < AdcTimingSnapshot::kBins; ++i)
+        rows[i / kBinsPerRow] += t.bins[i];
+    for (uint64_t r : rows)
+        rowMax = std::max(rowMax, r);
+    for (int r = 0; r < kRows && rowMax; ++r) {
+        if (!rows[r])
+            continue;
+        double lo = r * kBinsPerRow * AdcTimingSnapshot::kBinWidth;
+        QString range = r == kRows - 1 ? QString(">= %1 T").arg(lo, 0, 'f', 2)
+                                       : QString("%1-%2 T").arg(lo, 0, 'f', 2)
+                                             .arg(lo + kBinsPerRow * AdcTimingSnapshot::kBinWidth, 0, 'f', 2);
+        text += QString("  %1 %2 %3\n")
+            .arg(range, -11)
+            .arg(QString(int(rows[r] * 30 / rowMax) + 1, QChar('#')), -31)
+            .arg(rows[r]);
     }
+
+    text += "\nLatency since USB read (us)\n"
+            "stage            p50      p99      max\n";
+
+    const auto summaries = LatencyTrace::summarize();
+    for (int stage = 0; stage < LatencyTrace::StageCount; ++stage) {
+        const LatencyTrace::Summary &s = summaries[stage];
+        text += QString("%1 %2 %3 %4\n")
+            .arg(QString::fromLatin1(LatencyTrace::stageName(LatencyTrace::Stage(stage))), -14)
+            .arg(s.p50Ns / 1000.0, 8, 'f', 1)
+            .arg(s.p99Ns / 1000.0, 8, 'f', 1)
+            .arg(s.maxNs / 1000.0, 8, 'f', 1);
+    }
+
+    statusEdit->setPlainText(text);
+
+    if (FlightRecorder::takeDumpRequest())
+        dumpTrace();
 }
 
-void MainWindow::processLine(const QByteArray &line)
+void MainWindow::exportSamples()
 {
-    static enum { EXPECT_12, EXPECT_13, EXPECT_14 } state = EXPECT_12;
-    static uint8_t bytes[3];
-    static QString tripletTimestamp;
+    QString path = QFileDialog::getSaveFileName(this, "Export samples", "samples.csv",
+                                                "CSV files (*.csv)");
+    if (path.isEmpty())
+        return;
+
+    QString error;
+    if (exportSamplesCsv(store, calibrations.history(), path, &error))
+        statusBar()->showMessage(QString("Exported %1 samples to %2").arg(store.size()).arg(path), 5000);
+    else
+        statusBar()->showMessage("Export failed: " + error, 5000);
+}
 
-    QString strLine = QString::fromUtf8(line).trimmed();
-    if (!strLine.startsWith("[2AWA"))
+void MainWindow::exportCapture()
+{
+    int index = captureSelect->currentIndex();
+    if (index < 0 || index >= captures.size())
         return;
 
-    QString timestamp = QDateTime::currentDateTime().toString("hh:mm:ss.zzz");
-    rawEdit->append(QString("[%1] %2").arg(timestamp, strLine));
+    const TriggerCapture &capture = captures[index];
+    QString path = QFileDialog::getSaveFileName(this, "Export capture",
+                                                QString("capture-%1.csv").arg(capture.sequence),
+                                                "CSV files (*.csv)");
+    if (path.isEmpty())
+        return;
 
-    int rIndex = strLine.indexOf("[2AR");
-    if (rIndex == -1 || rIndex + 5 >= strLine.length()) {
-        state = EXPECT_12;
+    QString error;
+    if (exportCaptureCsv(capture, path, &error))
+        statusBar()->showMessage(QString("Exported capture #%1 to %2").arg(capture.sequence).arg(path), 5000);
+    else
+        statusBar()->showMessage("Export failed: " + error, 5000);
+}
+
+void MainWindow::exportRollups()
+{
+    QString path = QFileDialog::getSaveFileName(this, "Export rollups", "rollups.csv",
+                                                "CSV files (*.csv)");
+    if (path.isEmpty())
         return;
+
+    QString error;
+    if (exportRollupsCsv(secondRollups, minuteRollups, calibrations.history(), path, &error))
+        statusBar()->showMessage(QString("Exported %1 rollups to %2")
+                                     .arg(secondRollups.all().size() + minuteRollups.all().size())
+                                     .arg(path), 5000);
+    else
+        statusBar()->showMessage("Export failed: " + error, 5000);
+}
+
+void MainWindow::dumpTrace()
+{
+    QString path = QString("pipeline-trace-%1.json")
+        .arg(QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss"));
+
+    QString error;
+    if (FlightRecorder::dump(path, &error))
+        statusBar()->showMessage("Trace written to " + path, 5000);
+    else
+        statusBar()->showMessage("Trace dump failed: " + error, 5000);
+}
+
+// The history on screen is re-rendered from the store with the new values,
+// also while acquisition is stopped
+void MainWindow::applyCalibration(const Calibration &calibration)
+{
+    store.setCalibration(calibration);
+    taredLog->sync();
+    scaledLog->sync();
+}
+
+void MainWindow::onBatch(const DecodedBatch &batch)
+{
+    PipelineMetrics::add(PipelineMetrics::BatchesHandled);
+
+    // Follow calibrations published by the decoder (auto-zero)
+    const Calibration *calibration = calibrations.current();
+    if (calibration->version != store.calibration().version) {
+        applyCalibration(*calibration);
+        // Leave a tare the operator is typing alone
+        if (!tareInput->hasFocus() && !tareInput->isModified())
+            tareInput->setText(QString::number(calibration->tareValue));
     }
 
-    bool ok;
-    uint8_t value = strLine.mid(rIndex + 5, 2).toUInt(&ok, 16);
-    if (!ok) {
-        state = EXPECT_12;
-        return;
+    for (const RawLine &line : batch.lines)
+        rawLog->append(line.timestampUs, line.txn, line.text);
+
+    for (const DecodedSample &s : batch.samples) {
+        LatencyTrace::record(LatencyTrace::Queued, s.readNs);
+
+        store.append(s.timestampUs, s.code);
+
+        if (!paintOriginNs)
+            paintOriginNs = s.readNs;
     }
 
-    if (state == EXPECT_12 && strLine.startsWith("[2AWA12A")) {
-        bytes[0] = value;
-        tripletTimestamp = timestamp;
-        state = EXPECT_13;
+    for (const FilteredSample &f : batch.filtered)
+        filteredLog->append(f.timestampUs, f.grams, f.sigma);
+
+    rawLog->flush();
+    extractedLog->sync();
+    taredLog->sync();
+    scaledLog->sync();
+    filteredLog->flush();
+
+    for (const Rollup &r : batch.rollups) {
+        (r.intervalUs >= 60 * 1000000 ? minuteRollups : secondRollups).append(r);
+        const Calibration *used = calibrations.find(r.calibrationVersion);
+        rollupServer.publish(r, used ? *used : *calibration);
     }
-    else if (state == EXPECT_13 && strLine.startsWith("[2AWA13A")) {
-        bytes[1] = value;
-        state = EXPECT_14;
+
+    for (const StabilityEvent &event : batch.stabilityEvents)
+        logStabilityEvent(event);
+
+    for (const CheckweighItem &item : batch.items) {
+        logCheckweighItem(item);
+        addToSpc(item);
     }
-    else if (state == EXPECT_14 && strLine.startsWith("[2AWA14A")) {
-        bytes[2] = value;
 
-        uint32_t result =
-            (bytes[0] << 16) |
-            (bytes[1] << 8) |
-             bytes[2];
+    if (!batch.histogram.counts.empty())
+        histogramView->setSnapshot(batch.histogram);
+
+    if (!batch.items.isEmpty()) {
+        const CheckweighStats &s = batch.checkweigh;
+        checkweighLabel->setText(QString("%1 items, mean %2, sd %3, under %4, over %5, unsettled %6, %7 /min")
+                                     .arg(s.count)
+                                     .arg(s.mean, 0, 'f', 3)
+                                     .arg(s.stddev, 0, 'f', 3)
+                                     .arg(s.under)
+                                     .arg(s.over)
+                                     .arg(s.unsettled)
+                                     .arg(s.itemsPerMinute, 0, 'f', 0));
+    }
+
+    for (const TriggerCapture &capture : batch.captures) {
+        QString timestamp =
+            QDateTime::fromMSecsSinceEpoch(capture.triggerUs / 1000).toString("hh:mm:ss.zzz");
+        double lo = capture.points.front().value;
+        double hi = lo;
+        for (const TriggerCapture::Point &p : capture.points) {
+            lo = std::min(lo, p.value);
+            hi = std::max(hi, p.value);
+        }
+        eventLog->append(QString("[%1] trigger #%2: %3 (%4 samples, min %5, max %6)")
+                             .arg(timestamp)
+                             .arg(capture.sequence)
+                             .arg(capture.cause)
+                             .arg(capture.points.size())
+                             .arg(lo, 0, 'f', 3)
+                             .arg(hi, 0, 'f', 3));
+
+        captures.append(capture);
+        captureSelect->addItem(QString("#%1 %2 %3").arg(capture.sequence).arg(timestamp, capture.cause));
+        if (captures.size() > kMaxCaptures) {
+            captures.removeFirst();
+            captureSelect->removeItem(0);
+        }
+        captureSelect->setCurrentIndex(captureSelect->count() - 1);
+    }
+
+    if (!batch.samples.isEmpty()) {
+        latestCodeStats = batch.countWindow;
+        latestTiming = batch.timing;
+        feedSpectrum();
+    }
+
+    if (!batch.samples.isEmpty() && (!statsRefresh.isValid() || statsRefresh.elapsed() >= 100)) {
+        statsRefresh.start();
+        showStats(batch);
+    }
+}
+
+void MainWindow::feedSpectrum()
+{
+    const uint64_t length = spectrumLengthInput->currentData().toUInt();
+    const uint64_t end = store.endIndex();
+
+    // Blocks are consecutive; after falling behind, restart at the newest
+    if (spectrumNext < store.beginIndex() || spectrumNext > end || end - spectrumNext > 4 * length)
+        spectrumNext = end - std::min(end, length);
+    if (spectrumBusy || end - spectrumNext < length)
+        return;
+
+    QVector<double> block;
+    block.reserve(qsizetype(length));
+    int64_t firstUs = 0;
+    int64_t lastUs = 0;
+    store.forEachSpan(spectrumNext, spectrumNext + length,
+                      [&](const SampleStore::Block &b, size_t offset, size_t count) {
+        if (block.isEmpty())
+            firstUs = b.timestampUs[offset];
+        lastUs = b.timestampUs[offset + count - 1];
+        for (size_t i = offset; i < offset + count; ++i)
+            block.append(signExtend24(b.code[i]));
+    });
+    spectrumNext += length;
+
+    // The block's own spacing: the host may poll slower than the ADC converts
+    if (block.size() < 2 || lastUs <= firstUs)
+        return;
+    const double rateHz = 1e6 * double(block.size() - 1) / double(lastUs - firstUs);
 
-        result *= 1000;
+    spectrumBusy = true;
+    const uint64_t generation = spectrumGeneration;
+    QMetaObject::invokeMethod(spectrumAnalyzer, [this, block, rateHz, generation]() {
+        spectrumAnalyzer->analyze(block, rateHz, generation);
+    });
+}
+
+void MainWindow::restartSpectrum()
+{
+    spectrumGeneration++;
+    QMetaObject::invokeMethod(spectrumAnalyzer, [this]() { spectrumAnalyzer->reset(); });
+    spectrumView->clear();
+    spectrumNext = store.endIndex();
+}
+
+void MainWindow::logCheckweighItem(const CheckweighItem &item)
+{
+    static const char *const verdicts[] = { "ok", "UNDER", "OVER" };
 
-        extractedEdit->append(QString("[%1] %2").arg(tripletTimestamp).arg(result));
+    QString timestamp = QDateTime::fromMSecsSinceEpoch(item.loadUs / 1000).toString("hh:mm:ss.zzz");
+    eventLog->append(QString("[%1] item #%2: %3 %4 (%5 ms%6)")
+                         .arg(timestamp)
+                         .arg(item.sequence)
+                         .arg(item.weight, 0, 'f', 3)
+                         .arg(verdicts[item.verdict])
+                         .arg(item.durationUs / 1000)
+                         .arg(item.settled ? QString(", p-p %1").arg(item.spread, 0, 'f', 3)
+                                           : QString(", not settled")));
+}
 
-        int tared = result - tareValue;
-        taredEdit->append(QString("[%1] %2").arg(tripletTimestamp).arg(tared));
+void MainWindow::addToSpc(const CheckweighItem &item)
+{
+    // An unsettled weight carries the motion of the belt and would widen R-bar
+    if (!item.settled && !spcUnsettledInput->isChecked())
+        return;
 
-        float grams = static_cast<float>(tared) / scalingFactor;
-        scalingEdit->append(QString("[%1] %2").arg(tripletTimestamp).arg(grams, 0, 'f', 3));
+    SpcPoint point;
+    if (!spc.add(item.loadUs, item.weight, point))
+        return;
 
-        state = EXPECT_12;
+    QString timestamp = QDateTime::fromMSecsSinceEpoch(point.timestampUs / 1000).toString("hh:mm:ss.zzz");
+    for (int bit = 1; bit <= SpcPoint::CusumLow; bit <<= 1) {
+        if (point.violations & bit)
+            eventLog->append(QString("[%1] SPC subgroup %2: %3")
+                                 .arg(timestamp)
+                                 .arg(point.subgroup)
+                                 .arg(SpcChart::describe(SpcPoint::Violation(bit))));
+    }
+
+    const SpcLimits &lim = spc.limits();
+    if (lim.valid)
+        spcLabel->setText(QString("X-bar %1 [%2, %3], R %4 [%5, %6], %7 subgroups, %8 flagged")
+                              .arg(lim.center, 0, 'f', 3)
+                              .arg(lim.lcl, 0, 'f', 3)
+                              .arg(lim.ucl, 0, 'f', 3)
+                              .arg(lim.rangeCenter, 0, 'f', 3)
+                              .arg(lim.rangeLcl, 0, 'f', 3)
+                              .arg(lim.rangeUcl, 0, 'f', 3)
+                              .arg(point.subgroup)
+                              .arg(spc.violationCount()));
+    else
+        spcLabel->setText(QString("collecting baseline, %1 of %2 subgroups")
+                              .arg(point.subgroup)
+                              .arg(spc.settings().baselineSubgroups));
+    spcView->update();
+}
+
+void MainWindow::applySpcSettings()
+{
+    SpcSettings settings = spc.settings();
+    settings.subgroupSize = size_t(spcSubgroupInput->value());
+    settings.baselineSubgroups = size_t(spcBaselineInput->value());
+    spc.configure(settings);
+    spcLabel->setText("collecting baseline");
+    spcView->update();
+}
+
+void MainWindow::logStabilityEvent(const StabilityEvent &event)
+{
+    QString timestamp = QDateTime::fromMSecsSinceEpoch(event.timestampUs / 1000).toString("hh:mm:ss.zzz");
+
+    if (event.kind == StabilityEvent::Stable) {
+        stabilityLabel->setText(QString("STABLE %1").arg(event.value, 0, 'f', 3));
+        eventLog->append(QString("[%1] stable %2 (sd %3, settled in %4 s)")
+                             .arg(timestamp)
+                             .arg(event.value, 0, 'f', 3)
+                             .arg(event.stddev, 0, 'f', 4)
+                             .arg(event.settlingUs / 1e6, 0, 'f', 2));
     }
     else {
-        state = EXPECT_12;
+        stabilityLabel->setText("MOTION");
+        eventLog->append(QString("[%1] motion from %2").arg(timestamp).arg(event.value, 0, 'f', 3));
     }
 }
+
+void MainWindow::addCalibrationPoint()
+{
+    if (latestCodeStats.count == 0) {
+        statusBar()->showMessage("No samples yet", 5000);
+        return;
+    }
+
+    // Same units as the conversion, before the tare: code * 1000
+    double extracted = latestCodeStats.mean * 1000.0;
+    double tared = extracted - calibrations.current()->tareValue;
+    double weight = referenceWeightInput->value();
+    calibrationPoints.push_back({ extracted, weight });
+
+    pointsLabel->setText(QString("%1 points").arg(calibrationPoints.size()));
+    statusBar()->showMessage(QString("Point %1: %2 at tared %3 (mean of %4 samples, sd %5 codes)")
+                                 .arg(calibrationPoints.size())
+                                 .arg(weight)
+                                 .arg(tared, 0, 'f', 0)
+                                 .arg(latestCodeStats.count)
+                                 .arg(latestCodeStats.stddev, 0, 'f', 2), 5000);
+}
+
+void MainWindow::fitCalibration()
+{
+    int degree = curveKindInput->currentData().toInt();
+
+    // Fitted against the tare now in use; a later tare or auto-zero shifts
+    // the whole curve with it
+    const int64_t tare = calibrations.current()->tareValue;
+    CalibrationCurve curve;
+    std::string error;
+    if (!fitCalibrationCurve(calibrationPoints, tare, degree, curve, &error)) {
+        statusBar()->showMessage("Calibration not applied: " + QString::fromStdString(error), 5000);
+        return;
+    }
+
+    const Calibration *c = calibrations.publishCurve(curve, "multi-point");
+    applyCalibration(*c);
+
+    double worst = 0.0;
+    for (const CalibrationPoint &p : calibrationPoints)
+        worst = std::max(worst, std::fabs(scaledValue(int64_t(std::llround(p.extracted)) - c->tareValue, *c)
+                                          - p.weight));
+    statusBar()->showMessage(QString("%1 applied from %2 points, max residual %3")
+                                 .arg(curveKindInput->currentText())
+                                 .arg(calibrationPoints.size())
+                                 .arg(worst, 0, 'g', 4), 8000);
+}
+
+void MainWindow::showStats(const DecodedBatch &batch)
+{
+    auto line = [](const char *name, const StatsSnapshot &s) {
+        return QString("%1 n=%2  mean %3  sd %4  min %5  max %6  p-p %7  "
+                       "eff %8 bit  noise-free %9 bit")
+            .arg(name)
+            .arg(s.count, 6)
+            .arg(s.mean, 0, 'f', 1)
+            .arg(s.stddev, 0, 'f', 2)
+            .arg(s.min, 0, 'f', 0)
+            .arg(s.max, 0, 'f', 0)
+            .arg(s.peakToPeak(), 0, 'f', 0)
+            .arg(s.effectiveBits(), 0, 'f', 1)
+            .arg(s.noiseFreeBits(), 0, 'f', 1);
+    };
+
+    statsLabel->setText(line("last N:", batch.countWindow) + "\n" +
+                        line("last T:", batch.timeWindow));
+}
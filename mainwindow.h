@@ -4,10 +4,29 @@
 #include <QTextEdit>
 #include <QPushButton>
 #include <QLineEdit>
+#include <QLabel>
+#include <QSpinBox>
+#include <QDoubleSpinBox>
+#include <QComboBox>
+#include <QCheckBox>
 #include <QThread>
+#include <QTimer>
+#include <QElapsedTimer>
 #include <ftdi.h>
 
 #include "ftdireader.h"
+#include "calibration.h"
+#include "histogramview.h"
+#include "logview.h"
+#include "pipelinemetrics.h"
+#include "rollups.h"
+#include "rollupserver.h"
+#include "sampledecoder.h"
+#include "samplestore.h"
+#include "spc.h"
+#include "spcview.h"
+#include "spectrum.h"
+#include "spectrumview.h"
 
 class MainWindow : public QMainWindow
 {
@@ -17,28 +36,127 @@ public:
     explicit MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
 
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
 private slots:
-    void onFtdiBytes(const QByteArray &data);
-    void processLine(const QByteArray &line);
+    void onBatch(const DecodedBatch &batch);
+    void updateStatus();
+    void dumpTrace();
+    void exportSamples();
+    void exportCapture();
+    void exportRollups();
 
 private:
+    void applyCalibration(const Calibration &calibration);
+    void showStats(const DecodedBatch &batch);
+    void logStabilityEvent(const StabilityEvent &event);
+    void logCheckweighItem(const CheckweighItem &item);
+    void addToSpc(const CheckweighItem &item);
+    void applySpcSettings();
+    void addCalibrationPoint();
+    void fitCalibration();
+    void feedSpectrum();
+    void restartSpectrum();
+
     // UI
-    QTextEdit *rawEdit;
-    QTextEdit *extractedEdit;
-    QTextEdit *taredEdit;
-    QTextEdit *scalingEdit;
+    LogView *rawEdit;
+    LogView *extractedEdit;
+    LogView *taredEdit;
+    LogView *scalingEdit;
+    LogView *filteredEdit;
     QTextEdit *statusEdit;
 
+    RawLogModel *rawLog;
+    StoreLogModel *extractedLog;
+    StoreLogModel *taredLog;
+    StoreLogModel *scaledLog;
+    ValueLogModel *filteredLog;
+
     QPushButton *startStopButton;
+    QPushButton *exportButton;
+    QPushButton *traceButton;
+    QPushButton *dumpTraceButton;
     QPushButton *tareButton;
     QPushButton *scalingFactorButton;
     QLineEdit *tareInput;
     QLineEdit *scalingFactorInput;
 
+    QSpinBox *statsSamplesInput;
+    QDoubleSpinBox *statsSecondsInput;
+    QLabel *statsLabel;
+
+    QLineEdit *filterInput;
+
+    QSpinBox *stableWindowInput;
+    QDoubleSpinBox *stableStddevInput;
+    QDoubleSpinBox *stableSlopeInput;
+    QLabel *stabilityLabel;
+    QTextEdit *eventLog;
+
+    QComboBox *triggerTypeInput;
+    QComboBox *triggerEdgeInput;
+    QDoubleSpinBox *triggerThresholdInput;
+    QSpinBox *triggerStepInput;
+    QSpinBox *triggerPreInput;
+    QSpinBox *triggerPostInput;
+    QCheckBox *triggerSingleInput;
+    QPushButton *triggerArmButton;
+    QComboBox *captureSelect;
+    QPushButton *exportCaptureButton;
+    QVector<TriggerCapture> captures;
+
+    QCheckBox *autoZeroInput;
+    QDoubleSpinBox *autoZeroBandInput;
+    QDoubleSpinBox *autoZeroStableInput;
+    QDoubleSpinBox *autoZeroRateInput;
+    QDoubleSpinBox *autoZeroLimitInput;
+
+    QCheckBox *checkweighInput;
+    QDoubleSpinBox *checkweighLoadInput;
+    QDoubleSpinBox *checkweighUnloadInput;
+    QDoubleSpinBox *checkweighBandInput;
+    QSpinBox *checkweighSettleInput;
+    QDoubleSpinBox *checkweighLowerInput;
+    QDoubleSpinBox *checkweighUpperInput;
+    QPushButton *checkweighBatchButton;
+    QLabel *checkweighLabel;
+
+    QSpinBox *spcSubgroupInput;
+    QSpinBox *spcBaselineInput;
+    QCheckBox *spcUnsettledInput;
+    QPushButton *spcResetButton;
+    QLabel *spcLabel;
+    SpcView *spcView;
+
+    QComboBox *histogramSourceInput;
+    QComboBox *histogramModeInput;
+    QDoubleSpinBox *histogramWindowInput;
+    QPushButton *histogramResetButton;
+    HistogramView *histogramView;
+
+    QDoubleSpinBox *referenceWeightInput;
+    QPushButton *addPointButton;
+    QPushButton *clearPointsButton;
+    QComboBox *curveKindInput;
+    QPushButton *fitCurveButton;
+    QLabel *pointsLabel;
+    std::vector<CalibrationPoint> calibrationPoints;
+    StatsSnapshot latestCodeStats;
+    AdcTimingSnapshot latestTiming;
+
+    QPushButton *exportRollupsButton;
+    QSpinBox *rollupPortInput;
+    QCheckBox *rollupRemoteInput;
+    QPushButton *rollupServeButton;
+
+    SpectrumView *spectrumView;
+    QComboBox *spectrumLengthInput;
+    QPushButton *spectrumResetButton;
+    QElapsedTimer statsRefresh;
+
     // State
-    bool readingEnabled;
-    int scalingFactor;
-    int tareValue;
+    CalibrationRegistry calibrations;
 
     // FTDI
     ftdi_context *ftdi;
@@ -46,7 +164,27 @@ private:
     // Threading
     QThread *readerThread;
     FtdiReader *reader;
+    QThread *decoderThread;
+    SampleDecoder *decoder;
+    QThread *spectrumThread;
+    SpectrumAnalyzer *spectrumAnalyzer;
+
+    // Decoded history
+    SampleStore store;
+    RollupTable secondRollups;
+    RollupTable minuteRollups;
+    RollupServer rollupServer;
+    SpcChart spc;
+
+    // Next store index handed to the spectrum thread, one block in flight
+    uint64_t spectrumNext;
+    bool spectrumBusy;
+    uint64_t spectrumGeneration;    // bumped by a restart, stale results are dropped
 
-    // RX buffer
-    QByteArray rxBuffer;
+    // Status / metrics
+    QTimer *statusTimer;
+    PipelineMetrics::Snapshot lastMetrics;
+    QElapsedTimer lastMetricsTimer;
+    qint64 paintOriginNs;   // oldest read not yet painted, 0 if none
+    qint64 awakeNs;         // start of the current GUI event loop pass
 };
@@ -0,0 +1,319 @@
+#include "offlinedecoder.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTextStream>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include "adcconvert.h"
+#include "csvexport.h"
+
+namespace {
+
+constexpr size_t kMinChunkSize = 1 << 20;
+constexpr size_t kChunksPerThread = 8;
+
+struct Counters
+{
+    size_t lines = 0;
+    size_t transactions = 0;
+    size_t malformed = 0;
+};
+
+struct Chunk
+{
+    size_t begin = 0;
+    size_t end = 0;
+
+    // [begin, headEnd) is the part whose decode depends on the state carried
+    // in from the previous chunk; after it all entry states have converged.
+    size_t headEnd = 0;
+    size_t headSamples = 0;
+
+    TripletAssembler tail;  // final state when entered in Expect12
+    std::vector<AdcSample> samples;
+    Counters counters;
+};
+
+// Decodes one line into the assembler and hands completed samples to sink
+template <typename Sink>
+LineKind decodeLine(std::string_view raw, TripletAssembler &assembler,
+                    I2cTransaction &txn, Counters &counters, Sink &&sink)
+{
+    counters.lines++;
+
+    LineKind kind = parseTransaction(trimLine(raw), txn);
+    if (kind == LineKind::Malformed) {
+        counters.malformed++;
+        assembler.reset();
+    }
+    else if (kind == LineKind::Transaction) {
+        counters.transactions++;
+        AdcSample sample;
+        if (assembler.push(txn, 0, sample))
+            sink(sample);
+    }
+    return kind;
+}
+
+// Runs f on every line of [begin, end), including an unterminated last line
+template <typename F>
+void forEachLineInRange(const char *data, size_t begin, size_t end, F &&f)
+{
+    size_t used = forEachLine(data + begin, end - begin, f);
+    if (begin + used < end)
+        f(std::string_view(data + begin + used, end - begin - used));
+}
+
+void decodeChunk(const char *data, Chunk &chunk)
+{
+    TripletAssembler assembler;
+
+    // Entry states Expect13/Expect14 are followed alongside the Expect12 decode
+    // until all three agree; from there on the decode no longer depends on
+    // what the previous chunk left behind.
+    TripletAssembler::State alt[2] = { TripletAssembler::Expect13, TripletAssembler::Expect14 };
+    bool converged = false;
+
+    chunk.samples.reserve((chunk.end - chunk.begin) / 64);
+
+    forEachLineInRange(data, chunk.begin, chunk.end, [&](std::string_view raw) {
+        I2cTransaction txn;
+        LineKind kind = decodeLine(raw, assembler, txn, chunk.counters,
+                                   [&](const AdcSample &s) { chunk.samples.push_back(s); });
+        if (converged || kind == LineKind::Ignored)
+            return;
+
+        const I2cTransaction *p = kind == LineKind::Transaction ? &txn : nullptr;
+        alt[0] = TripletAssembler::next(alt[0], p);
+        alt[1] = TripletAssembler::next(alt[1], p);
+
+        if (alt[0] == assembler.state() && alt[1] == assembler.state()) {
+            converged = true;
+            chunk.headEnd = std::min(size_t(raw.data() - data) + raw.size() + 1, chunk.end);
+            chunk.headSamples = chunk.samples.size();
+        }
+    });
+
+    if (!converged) {
+        chunk.headEnd = chunk.end;
+        chunk.headSamples = chunk.samples.size();
+    }
+    chunk.tail = assembler;
+}
+
+std::vector<Chunk> splitChunks(const char *data, size_t size, unsigned threads)
+{
+    size_t target = std::max(kMinChunkSize, size / (size_t(threads) * kChunksPerThread));
+
+    std::vector<Chunk> chunks;
+    size_t begin = 0;
+    while (begin < size) {
+        size_t end = size;
+        if (size - begin > target) {
+            const char *nl = static_cast<const char *>(
+                std::memchr(data + begin + target, '\n', size - begin - target));
+            if (nl)
+                end = nl - data + 1;
+        }
+
+        Chunk chunk;
+        chunk.begin = begin;
+        chunk.end = end;
+        chunks.push_back(std::move(chunk));
+        begin = end;
+    }
+    return chunks;
+}
+
+} // namespace
+
+OfflineDecodeResult OfflineDecoder::decode(const char *data, size_t size, unsigned threads)
+{
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    std::vector<Chunk> chunks = splitChunks(data, size, threads);
+    threads = std::min<unsigned>(threads, chunks.size());
+
+    std::atomic<size_t> nextChunk{0};
+    auto worker = [&]() {
+        for (size_t i = nextChunk++; i < chunks.size(); i = nextChunk++)
+            decodeChunk(data, chunks[i]);
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; ++t)
+        pool.emplace_back(worker);
+    worker();
+    for (std::thread &t : pool)
+        t.join();
+
+    // ---- Stitch in order ----
+    OfflineDecodeResult result;
+
+    size_t total = 0;
+    for (const Chunk &chunk : chunks)
+        total += chunk.samples.size() + 1;
+    result.samples.reserve(total);
+
+    TripletAssembler carry;
+    for (Chunk &chunk : chunks) {
+        result.lines += chunk.counters.lines;
+        result.transactions += chunk.counters.transactions;
+        result.malformed += chunk.counters.malformed;
+
+        if (carry.state() == TripletAssembler::Expect12) {
+            result.samples.insert(result.samples.end(), chunk.samples.begin(), chunk.samples.end());
+            carry = chunk.tail;
+        }
+        else {
+            // A triplet is open across the boundary: redo the head with the real state
+            Counters ignored;
+            forEachLineInRange(data, chunk.begin, chunk.headEnd, [&](std::string_view raw) {
+                I2cTransaction txn;
+                decodeLine(raw, carry, txn, ignored,
+                           [&](const AdcSample &s) { result.samples.push_back(s); });
+            });
+            result.samples.insert(result.samples.end(),
+                                  chunk.samples.begin() + chunk.headSamples, chunk.samples.end());
+            if (chunk.headEnd != chunk.end)
+                carry = chunk.tail;
+        }
+
+        std::vector<AdcSample>().swap(chunk.samples);
+    }
+
+    return result;
+}
+
+bool OfflineDecoder::decodeFile(const QString &path, OfflineDecodeResult &result,
+                                unsigned threads, QString *error)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error) *error = file.errorString();
+        return false;
+    }
+
+    qint64 size = file.size();
+    if (size == 0) {
+        result = OfflineDecodeResult();
+        return true;
+    }
+
+    uchar *map = file.map(0, size);
+    if (!map) {
+        if (error) *error = file.errorString();
+        return false;
+    }
+
+    result = decode(reinterpret_cast<const char *>(map), size_t(size), threads);
+    file.unmap(map);
+    return true;
+}
+
+int runOfflineDecode(const QStringList &args)
+{
+    QTextStream err(stderr);
+
+    QString capturePath;
+    QString outputPath;
+    unsigned threads = 0;
+    Calibration calibration;
+    bool valid = true;
+
+    for (int i = 1; i < args.size() && valid; ++i) {
+        const QString &arg = args[i];
+        if (arg == "--decode")
+            continue;
+        if (arg == "--threads" || arg == "--tare" || arg == "--scale") {
+            bool ok = i + 1 < args.size();
+            const QString value = ok ? args[++i] : QString();
+            if (arg == "--threads")
+                threads = value.toUInt(&ok);
+            else if (arg == "--tare")
+                calibration.tareValue = value.toLongLong(&ok);
+            else
+                calibration.scalingFactor = value.toInt(&ok);
+            if (arg == "--tare")
+                ok = ok && calibration.tareValue >= -kTareLimit && calibration.tareValue <= kTareLimit;
+            if (!ok || (arg == "--scale" && calibration.scalingFactor == 0)) {
+                err << "Invalid value for " << arg << ": '" << value << "'\n";
+                valid = false;
+            }
+        }
+        else if (capturePath.isEmpty()) {
+            capturePath = arg;
+        }
+        else {
+            outputPath = arg;
+        }
+    }
+
+    if (!valid || capturePath.isEmpty()) {
+        err << "Usage: FTDI_Viewer --decode <capture> [output.csv] [--threads N]"
+               " [--tare N] [--scale N]\n";
+        return 1;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    OfflineDecodeResult result;
+    QString error;
+    if (!OfflineDecoder::decodeFile(capturePath, result, threads, &error)) {
+        err << "Cannot read " << capturePath << ": " << error << "\n";
+        return 1;
+    }
+
+    qint64 decodeMs = timer.elapsed();
+
+    QFile out(outputPath);
+    bool opened = outputPath.isEmpty()
+        ? out.open(stdout, QIODevice::WriteOnly)
+        : out.open(QIODevice::WriteOnly | QIODevice::Truncate);
+    if (!opened) {
+        err << "Cannot write " << outputPath << ": " << out.errorString() << "\n";
+        return 1;
+    }
+
+    CsvWriter csv(&out);
+    csv.field("index").field("code").field("tared").field("scaled");
+    csv.endRow();
+
+    // Convert in cache-sized batches with the same kernel as the live view
+    constexpr size_t kBatch = 4096;
+    uint32_t codes[kBatch];
+    int64_t tared[kBatch];
+    double scaled[kBatch];
+    for (size_t base = 0; base < result.samples.size(); base += kBatch) {
+        size_t n = std::min(kBatch, result.samples.size() - base);
+        for (size_t i = 0; i < n; ++i)
+            codes[i] = result.samples[base + i].code;
+        convertBatch(codes, n, calibration, tared, scaled);
+
+        for (size_t i = 0; i < n; ++i) {
+            csv.field(uint64_t(base + i))
+               .field(uint64_t(codes[i]))
+               .field(int64_t(tared[i]))
+               .field(scaled[i], 3);
+            csv.endRow();
+        }
+    }
+    csv.flush();
+    out.close();
+
+    QFile capture(capturePath);
+    double mb = capture.size() / (1024.0 * 1024.0);
+    err << "Decoded " << result.samples.size() << " samples from "
+        << result.lines << " lines (" << result.malformed << " malformed), "
+        << QString::number(mb, 'f', 1) << " MiB in " << decodeMs << " ms";
+    if (decodeMs > 0)
+        err << " (" << QString::number(mb * 1000.0 / decodeMs, 'f', 1) << " MiB/s)";
+    err << "\n";
+
+    return 0;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <vector>
+
+#include "i2cdecoder.h"
+
+struct OfflineDecodeResult
+{
+    std::vector<AdcSample> samples;
+    size_t lines = 0;
+    size_t transactions = 0;
+    size_t malformed = 0;
+};
+
+// Decodes a raw sniffer capture on all cores. The buffer is split at line
+// boundaries, chunks are decoded in parallel and stitched back in order,
+// so the result is identical to a sequential decode.
+class OfflineDecoder
+{
+public:
+    static OfflineDecodeResult decode(const char *data, size_t size, unsigned threads = 0);
+
+    // Memory-maps the capture file and decodes it
+    static bool decodeFile(const QString &path, OfflineDecodeResult &result,
+                           unsigned threads = 0, QString *error = nullptr);
+};
+
+// Entry point for "FTDI_Viewer --decode <capture> [output.csv] [--threads N]"
+int runOfflineDecode(const QStringList &args);
@@ -0,0 +1,51 @@
+#include "pipelinemetrics.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#elif defined(__linux__)
+#include <cstdio>
+#include <unistd.h>
+#endif
+
+std::atomic<uint64_t> PipelineMetrics::counters[PipelineMetrics::CounterCount];
+std::atomic<uint64_t> PipelineMetrics::maxFrameNs{0};
+
+PipelineMetrics::Snapshot PipelineMetrics::snapshot()
+{
+    Snapshot s;
+    for (int i = 0; i < CounterCount; ++i)
+        s[i] = counters[i].load(std::memory_order_relaxed);
+    return s;
+}
+
+void PipelineMetrics::raiseMaxFrameNs(uint64_t ns)
+{
+    if (ns > maxFrameNs.load(std::memory_order_relaxed))
+        maxFrameNs.store(ns, std::memory_order_relaxed);
+}
+
+uint64_t PipelineMetrics::takeMaxFrameNs()
+{
+    return maxFrameNs.exchange(0, std::memory_order_relaxed);
+}
+
+uint64_t PipelineMetrics::processMemoryBytes()
+{
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+        return pmc.WorkingSetSize;
+    return 0;
+#elif defined(__linux__)
+    unsigned long pages = 0, resident = 0;
+    FILE *f = std::fopen("/proc/self/statm", "r");
+    if (!f)
+        return 0;
+    int n = std::fscanf(f, "%lu %lu", &pages, &resident);
+    std::fclose(f);
+    return n == 2 ? uint64_t(resident) * sysconf(_SC_PAGESIZE) : 0;
+#else
+    return 0;
+#endif
+}
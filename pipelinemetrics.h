@@ -0,0 +1,53 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Throughput counters shared by the reader, decoder and GUI threads. Every counter
+// has a single writer, so an update is a relaxed load/store pair; the status
+// timer samples them at a low rate and turns the deltas into rates.
+class PipelineMetrics
+{
+public:
+    enum Counter
+    {
+        UsbBytes,
+        UsbReads,
+        ChunksQueued,       // reader side of the reader -> decoder queue
+        ChunksHandled,      // decoder side of the same queue
+        BatchesQueued,      // decoder side of the decoder -> GUI queue
+        BatchesHandled,     // GUI side of the same queue
+        DroppedBytes,       // received while acquisition is stopped
+        Lines,
+        Transactions,
+        MalformedLines,
+        Samples,
+        DecoderNs,
+        GuiFrames,
+        GuiFrameNs,
+        CounterCount
+    };
+
+    using Snapshot = std::array<uint64_t, CounterCount>;
+
+    static void add(Counter counter, uint64_t n = 1)
+    {
+        std::atomic<uint64_t> &c = counters[counter];
+        c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    static uint64_t value(Counter counter) { return counters[counter].load(std::memory_order_relaxed); }
+    static Snapshot snapshot();
+
+    // Longest GUI frame since the last takeMaxFrameNs()
+    static void raiseMaxFrameNs(uint64_t ns);
+    static uint64_t takeMaxFrameNs();
+
+    // Resident set size, 0 where unsupported
+    static uint64_t processMemoryBytes();
+
+private:
+    static std::atomic<uint64_t> counters[CounterCount];
+    static std::atomic<uint64_t> maxFrameNs;
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+// Growable circular buffer usable as a deque. Capacity only grows (in
+// powers of two), so in steady state pushes and pops never allocate.
+template <typename T>
+class RingDeque
+{
+public:
+    explicit RingDeque(size_t initialCapacity = 16)
+    {
+        size_t cap = 1;
+        while (cap < initialCapacity)
+            cap <<= 1;
+        buf = std::make_unique<T[]>(cap);
+        mask = cap - 1;
+    }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    size_t capacity() const { return mask + 1; }
+
+    T &operator[](size_t i) { return buf[(head + i) & mask]; }
+    const T &operator[](size_t i) const { return buf[(head + i) & mask]; }
+
+    T &front() { return buf[head]; }
+    const T &front() const { return buf[head]; }
+    T &back() { return buf[(head + count - 1) & mask]; }
+    const T &back() const { return buf[(head + count - 1) & mask]; }
+
+    void push_back(const T &value)
+    {
+        if (count == capacity())
+            grow();
+        buf[(head + count) & mask] = value;
+        count++;
+    }
+
+    void pop_front()
+    {
+        head = (head + 1) & mask;
+        count--;
+    }
+
+    void pop_back() { count--; }
+    void clear() { head = 0; count = 0; }
+
+private:
+    void grow()
+    {
+        size_t cap = capacity() * 2;
+        auto bigger = std::make_unique<T[]>(cap);
+        for (size_t i = 0; i < count; ++i)
+            bigger[i] = std::move((*this)[i]);
+        buf = std::move(bigger);
+        mask = cap - 1;
+        head = 0;
+    }
+
+    std::unique_ptr<T[]> buf;
+    size_t mask = 0;
+    size_t head = 0;
+    size_t count = 0;
+};
@@ -0,0 +1,92 @@
+#include "rollups.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "adcconvert.h"
+#include "csvexport.h"
+
+double Rollup::stddev() const
+{
+    if (count < 2)
+        return 0.0;
+    double n = double(count);
+    double var = (double(sumSq) - double(sum) * double(sum) / n) / (n - 1);
+    return var > 0.0 ? std::sqrt(var) : 0.0;
+}
+
+bool RollupAggregator::add(int64_t timestampUs, int32_t code, uint32_t calibrationVersion,
+                           Rollup &completed)
+{
+    int64_t start = timestampUs - timestampUs % intervalUs;
+    bool closed = false;
+
+    if (current.count && start != current.startUs) {
+        completed = current;
+        closed = true;
+        current.count = 0;
+    }
+
+    if (current.count == 0) {
+        current.startUs = start;
+        current.intervalUs = intervalUs;
+        current.first = current.min = current.max = code;
+        current.sum = current.sumSq = 0;
+    }
+
+    int64_t d = int64_t(code) - current.first;
+    current.count++;
+    current.last = code;
+    current.calibrationVersion = calibrationVersion;
+    current.min = std::min(current.min, code);
+    current.max = std::max(current.max, code);
+    current.sum += d;
+    current.sumSq += d * d;
+    return closed;
+}
+
+void RollupTable::append(const Rollup &r)
+{
+    rows.push_back(r);
+    if (rows.size() > maxRows)
+        rows.pop_front();
+}
+
+void writeRollupHeader(CsvWriter &csv)
+{
+    csv.field("interval_s").field("start_us").field("count").field("mean")
+       .field("min").field("max").field("stddev").field("first").field("last")
+       .field("calibration");
+    csv.endRow();
+}
+
+void writeRollupRow(CsvWriter &csv, const Rollup &r, const Calibration &calibration)
+{
+    auto scaled = [&calibration](double code) {
+        return scaledValue(int64_t(std::llround(code * 1000.0)) - calibration.tareValue, calibration);
+    };
+
+    double mean = scaled(r.mean());
+    double lo = scaled(r.min);
+    double hi = scaled(r.max);
+    double slope = sensitivityAt(r.mean() * 1000.0 - calibration.tareValue, calibration);
+
+    // E[c2 t^2] = c2 (mean^2 + variance): the curve at the mean misses the
+    // variance term
+    if (calibration.curve.kind == CalibrationCurve::Polynomial && r.count > 1) {
+        double sd = r.stddev() * 1000.0;
+        mean += calibration.curve.c[2] * sd * sd * double(r.count - 1) / double(r.count);
+    }
+
+    csv.field(int64_t(r.intervalUs / 1000000))
+       .field(int64_t(r.startUs))
+       .field(uint64_t(r.count))
+       .field(mean, 4)
+       .field(std::min(lo, hi), 4)
+       .field(std::max(lo, hi), 4)
+       .field(r.stddev() * 1000.0 * std::fabs(slope), 5)
+       .field(scaled(r.first), 4)
+       .field(scaled(r.last), 4)
+       .field(uint64_t(r.calibrationVersion));
+    csv.endRow();
+}
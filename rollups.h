@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+#include "calibration.h"
+
+class CsvWriter;
+
+// Summary of the samples in one wall-clock interval, kept in sign-extended
+// code units. It is converted for output with the calibration that was in
+// effect for its last sample. Sums are taken relative to the first code,
+// which keeps them exact and the variance free of cancellation.
+struct Rollup
+{
+    int64_t startUs = 0;
+    int64_t intervalUs = 0;
+    uint32_t count = 0;
+    int32_t first = 0;
+    int32_t last = 0;
+    int32_t min = 0;
+    int32_t max = 0;
+    int64_t sum = 0;        // of (code - first)
+    int64_t sumSq = 0;      // of (code - first)^2
+    uint32_t calibrationVersion = 0;
+
+    double mean() const { return count ? first + double(sum) / count : 0.0; }
+    double stddev() const;
+};
+
+// Builds rollups of a fixed interval from a timestamped code stream. An
+// interval is complete when the first sample of a later one arrives.
+class RollupAggregator
+{
+public:
+    explicit RollupAggregator(int64_t intervalUs) : intervalUs(intervalUs) {}
+
+    // Returns true and fills 'completed' when the sample closes an interval
+    bool add(int64_t timestampUs, int32_t code, uint32_t calibrationVersion, Rollup &completed);
+
+private:
+    int64_t intervalUs;
+    Rollup current;
+};
+
+// Bounded history of completed rollups of one interval
+class RollupTable
+{
+public:
+    explicit RollupTable(size_t maxRows) : maxRows(maxRows) {}
+
+    void append(const Rollup &r);
+    void clear() { rows.clear(); }
+
+    const std::deque<Rollup> &all() const { return rows; }
+
+private:
+    size_t maxRows;
+    std::deque<Rollup> rows;
+};
+
+// CSV layout shared by the export and the rollup server:
+//   interval_s,start_us,count,mean,min,max,stddev,first,last,calibration
+// Values are converted with 'calibration', which should be the rollup's
+// calibrationVersion. min, max, first and last are exact. The mean of a
+// quadratic curve is exact too (it adds c2 times the variance); on a
+// piecewise curve it is exact only within one segment. stddev uses the
+// curve's slope at the mean.
+void writeRollupHeader(CsvWriter &csv);
+void writeRollupRow(CsvWriter &csv, const Rollup &r, const Calibration &calibration);
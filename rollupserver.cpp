@@ -0,0 +1,65 @@
+#include "rollupserver.h"
+
+#include <algorithm>
+
+namespace {
+
+constexpr size_t kClientBuffer = 4096;
+
+} // namespace
+
+RollupServer::RollupServer(QObject *parent)
+    : QObject(parent)
+{
+    connect(&server, &QTcpServer::newConnection, this, &RollupServer::onNewConnection);
+}
+
+bool RollupServer::listen(quint16 port, const QHostAddress &address, QString *error)
+{
+    if (server.listen(address, port))
+        return true;
+    if (error) *error = server.errorString();
+    return false;
+}
+
+void RollupServer::close()
+{
+    server.close();
+
+    // disconnectFromHost() may emit disconnected() right away
+    std::vector<Client> closing = std::move(clients);
+    clients.clear();
+    for (Client &c : closing) {
+        c.csv.reset();
+        c.socket->disconnectFromHost();
+    }
+}
+
+void RollupServer::onNewConnection()
+{
+    while (QTcpSocket *socket = server.nextPendingConnection()) {
+        Client client{ socket, std::make_unique<CsvWriter>(socket, kClientBuffer) };
+        writeRollupHeader(*client.csv);
+        client.csv->flush();
+
+        connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+            auto it = std::find_if(clients.begin(), clients.end(),
+                                   [socket](const Client &c) { return c.socket == socket; });
+            if (it != clients.end()) {
+                it->csv.reset();
+                clients.erase(it);
+            }
+            socket->deleteLater();
+        });
+
+        clients.push_back(std::move(client));
+    }
+}
+
+void RollupServer::publish(const Rollup &rollup, const Calibration &calibration)
+{
+    for (Client &c : clients) {
+        writeRollupRow(*c.csv, rollup, calibration);
+        c.csv->flush();
+    }
+}
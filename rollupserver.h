@@ -0,0 +1,44 @@
+#pragma once
+
+#include <QHostAddress>
+#include <QObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <memory>
+#include <vector>
+
+#include "calibration.h"
+#include "csvexport.h"
+#include "rollups.h"
+
+// Pushes completed rollups to TCP clients, one CSV row per rollup in the
+// same layout as the export. A client receives the header on connect and
+// every rollup completed afterwards; nothing needs to be sent.
+class RollupServer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit RollupServer(QObject *parent = nullptr);
+
+    // Only local clients by default; QHostAddress::Any opens it to the network
+    bool listen(quint16 port, const QHostAddress &address = QHostAddress::LocalHost,
+                QString *error = nullptr);
+    void close();
+    bool isListening() const { return server.isListening(); }
+    size_t clientCount() const { return clients.size(); }
+
+    void publish(const Rollup &rollup, const Calibration &calibration);
+
+private slots:
+    void onNewConnection();
+
+private:
+    struct Client
+    {
+        QTcpSocket *socket;
+        std::unique_ptr<CsvWriter> csv;
+    };
+
+    QTcpServer server;
+    std::vector<Client> clients;
+};
@@ -0,0 +1,324 @@
+#include "sampledecoder.h"
+
+#include <QDateTime>
+#include <algorithm>
+#include <cstring>
+
+#include "adcconvert.h"
+#include "flightrecorder.h"
+#include "latencytrace.h"
+#include "pipelinemetrics.h"
+
+namespace {
+
+// Histogram snapshots sent to the GUI, about one per frame
+constexpr int64_t kHistogramIntervalUs = 50000;
+
+} // namespace
+
+SampleDecoder::SampleDecoder(CalibrationRegistry *calibrations, QObject *parent)
+    : QObject(parent),
+      calibrations(calibrations),
+      countStats(320, 0),
+      timeStats(0, 10 * 1000000)
+{
+    timing.setRate(sampleRateHz);
+}
+
+void SampleDecoder::setStatsWindows(int samples, double seconds)
+{
+    countStats.setWindow(size_t(std::max(samples, 1)), 0);
+    timeStats.setWindow(0, int64_t(seconds * 1e6));
+}
+
+// Only the rate dependent stages follow; filter, detector and trigger state
+// is kept. A spec that cannot run at the new rate leaves the samples
+// unfiltered until the rate or the spec changes.
+void SampleDecoder::setSampleRate(double rateHz)
+{
+    sampleRateHz = rateHz;
+    timing.setRate(rateHz);
+
+    QString error;
+    if (filterInvalid) {
+        FilterChain chain;
+        if (FilterChain::parse(filterSpec, rateHz, chain, &error)) {
+            filter = std::move(chain);
+            filterInvalid = false;
+            applyOutputRate();
+            emit filterChanged(filter.describe(), QString());
+            return;
+        }
+    }
+    else if (filter.setSampleRate(rateHz, &error)) {
+        applyOutputRate();
+        return;
+    }
+
+    filter = FilterChain();
+    filterInvalid = true;
+    applyOutputRate();
+    emit filterSuspended(QString("%1 at %2 SPS").arg(error).arg(rateHz));
+}
+
+// CTRL2 traffic, written or read back, tells us the conversion rate the
+// host configured
+void SampleDecoder::applyCtrl2(const I2cTransaction &txn)
+{
+    if (txn.reg != 0x02)
+        return;
+    double rate = AdcTimingAnalyzer::rateFromCtrl2(txn.value);
+    if (rate > 0.0 && rate != sampleRateHz)
+        setSampleRate(rate);
+}
+
+void SampleDecoder::setFilter(const QString &spec)
+{
+    QString error;
+    if (!FilterChain::parse(spec, sampleRateHz, filter, &error)) {
+        emit filterChanged(filter.describe(), error);
+        return;
+    }
+    filterSpec = spec;
+    filterInvalid = false;
+
+    applyOutputRate();
+    emit filterChanged(filter.describe(), QString());
+}
+
+// The detectors keep their state, and the trigger its arm state and any
+// capture in progress, when only the rate of the filter output changes
+void SampleDecoder::applyOutputRate()
+{
+    const double rateHz = sampleRateHz / double(filter.decimation());
+    stability.setSampleRate(rateHz);
+    trigger.setSampleRate(rateHz);
+}
+
+void SampleDecoder::setStabilityParameters(const StabilityParameters &params)
+{
+    StabilityParameters p = params;
+    p.sampleRateHz = sampleRateHz / double(filter.decimation());
+    stability.setParameters(p);
+}
+
+void SampleDecoder::configureTrigger(const TriggerSettings &settings)
+{
+    TriggerSettings s = settings;
+    s.sampleRateHz = sampleRateHz / double(filter.decimation());
+    trigger.configure(s);
+}
+
+void SampleDecoder::armTrigger()
+{
+    trigger.arm();
+}
+
+void SampleDecoder::configureAutoZero(const AutoZeroSettings &settings)
+{
+    autoZero.configure(settings);
+}
+
+void SampleDecoder::configureCheckweigher(const CheckweigherSettings &settings)
+{
+    checkweigher.configure(settings);
+}
+
+void SampleDecoder::newCheckweighBatch()
+{
+    checkweigher.newBatch();
+}
+
+void SampleDecoder::configureHistogram(const HistogramSettings &settings)
+{
+    histogram.configure(settings);
+}
+
+void SampleDecoder::resetHistogram()
+{
+    histogram.reset();
+}
+
+void SampleDecoder::onBytes(const QByteArray &data, qint64 readNs)
+{
+    PipelineMetrics::add(PipelineMetrics::ChunksHandled);
+
+    if (!enabled.load(std::memory_order_relaxed)) {
+        PipelineMetrics::add(PipelineMetrics::DroppedBytes, data.size());
+        return;
+    }
+
+    FlightRecorder::setThreadName("decoder");
+    TraceSpan span("decode batch", data.size());
+    qint64 startNs = LatencyTrace::now();
+
+    if (!haveWallOffset) {
+        wallOffsetUs = QDateTime::currentMSecsSinceEpoch() * 1000 - startNs / 1000;
+        haveWallOffset = true;
+    }
+
+    // Capture time of a line is the arrival of its '\n': the last byte came
+    // in at the end of the read, earlier ones one character time apart
+    const char *begin = data.constData();
+    const size_t len = size_t(data.size());
+    const int64_t readEndUs = readNs / 1000 + wallOffsetUs;
+    const double usPerByte = 10 * 1e6 / kSnifferBaudRate;
+    const char *firstNewline = static_cast<const char *>(std::memchr(begin, '\n', len));
+
+    DecodedBatch batch;
+    splitter.feed(begin, len, [&](std::string_view line) {
+        // A line completing a partial one from the previous read lives in
+        // the splitter's buffer; it ends at the first '\n' of this read
+        const char *nl = line.data() >= begin && line.data() < begin + len
+            ? line.data() + line.size() : firstNewline;
+        int64_t captureUs = readEndUs - int64_t(double(begin + len - 1 - nl) * usPerByte);
+        processLine(line, readNs, captureUs, batch);
+    });
+
+    PipelineMetrics::add(PipelineMetrics::DecoderNs, LatencyTrace::now() - startNs);
+
+    if (batch.lines.isEmpty())
+        return;
+
+    if (!batch.samples.isEmpty()) {
+        filterBatch(batch);
+        batch.countWindow = countStats.snapshot();
+        batch.timeWindow = timeStats.snapshot();
+        batch.timing = timing.snapshot();
+    }
+
+    PipelineMetrics::add(PipelineMetrics::BatchesQueued);
+    emit batchReady(batch);
+}
+
+void SampleDecoder::filterBatch(DecodedBatch &batch)
+{
+    TraceSpan span("filter", batch.samples.size());
+
+    const size_t n = size_t(batch.samples.size());
+    filterTimestamps.resize(n);
+    filterValues.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        filterTimestamps[i] = batch.samples[i].timestampUs;
+        filterValues[i] = batch.samples[i].grams;
+    }
+
+    size_t out = filter.process(filterTimestamps.data(), filterValues.data(), n);
+    const double *sigma = filter.uncertainty();
+
+    batch.filtered.reserve(qsizetype(out));
+    for (size_t i = 0; i < out; ++i) {
+        batch.filtered.append({ filterTimestamps[i], filterValues[i], sigma ? sigma[i] : -1.0 });
+
+        StabilityEvent event;
+        bool motion = false;
+        if (stability.add(filterTimestamps[i], filterValues[i], event)) {
+            batch.stabilityEvents.append(event);
+            motion = event.kind == StabilityEvent::Motion;
+        }
+
+        TriggerCapture capture;
+        if (trigger.add(filterTimestamps[i], filterValues[i], motion, capture))
+            batch.captures.append(std::move(capture));
+
+        CheckweighItem item;
+        bool haveItem = checkweigher.add(filterTimestamps[i], filterValues[i], item);
+        if (haveItem)
+            batch.items.append(item);
+
+        if (histogram.settings().source == HistogramSettings::Readings)
+            histogram.add(filterTimestamps[i], filterValues[i]);
+        else if (haveItem)
+            histogram.add(item.loadUs, item.weight);
+    }
+
+    if (!batch.items.isEmpty())
+        batch.checkweigh = checkweigher.stats();
+
+    if (out && !histogram.isEmpty() && filterTimestamps[out - 1] - histogramSentUs >= kHistogramIntervalUs) {
+        histogramSentUs = filterTimestamps[out - 1];
+        histogram.snapshot(histogramSentUs, batch.histogram);
+    }
+}
+
+void SampleDecoder::processLine(std::string_view rawLine, qint64 readNs, int64_t captureUs,
+                                DecodedBatch &batch)
+{
+    LatencyTrace::record(LatencyTrace::Split, readNs);
+    PipelineMetrics::add(PipelineMetrics::Lines);
+
+    std::string_view line = trimLine(rawLine);
+
+    I2cTransaction txn{};
+    LineKind kind = parseTransaction(line, txn);
+    if (kind == LineKind::Ignored)
+        return;
+
+    LatencyTrace::record(LatencyTrace::Decode, readNs);
+
+    // Lines in the usual layout travel as their transaction only
+    RawLine raw{ captureUs, txn, QByteArray() };
+    bool usual = kind == LineKind::Transaction && line.size() == kTransactionLineLength;
+    if (usual) {
+        char text[kTransactionLineLength];
+        formatTransaction(txn, text);
+        usual = std::memcmp(line.data(), text, kTransactionLineLength) == 0;
+    }
+    if (!usual)
+        raw.text = QByteArray(line.data(), qsizetype(line.size()));
+    batch.lines.append(raw);
+
+    if (kind == LineKind::Malformed) {
+        I2cTransaction write{};
+        if (parseRegisterWrite(line, write)) {
+            PipelineMetrics::add(PipelineMetrics::Transactions);
+            applyCtrl2(write);
+        }
+        else {
+            PipelineMetrics::add(PipelineMetrics::MalformedLines);
+        }
+        assembler.reset();
+        return;
+    }
+
+    PipelineMetrics::add(PipelineMetrics::Transactions);
+    applyCtrl2(txn);
+
+    AdcSample sample;
+    if (!assembler.push(txn, captureUs, sample))
+        return;
+
+    PipelineMetrics::add(PipelineMetrics::Samples);
+    timing.add(sample.timestampUs, sample.code);
+
+    // One acquire load per sample: a new calibration applies from exactly
+    // the first sample converted after it was published
+    const Calibration *calibration = calibrations->current();
+    if (calibration->version != lastVersion) {
+        calibrations->markEffective(calibration->version, sampleIndex, sample.timestampUs);
+        lastVersion = calibration->version;
+        autoZero.calibrationChanged(*calibration);
+    }
+
+    ConvertedSample c = convertSample(sample.code, *calibration);
+    LatencyTrace::record(LatencyTrace::Convert, readNs);
+
+    // Applies from the next sample, like a tare set in the GUI
+    int64_t newTare;
+    if (autoZero.add(sample.timestampUs, c.tared, *calibration, newTare))
+        calibrations->publishTare(newTare, "auto-zero");
+
+    int32_t code = signExtend24(sample.code);
+    countStats.add(sample.timestampUs, code);
+    timeStats.add(sample.timestampUs, code);
+
+    Rollup rollup;
+    if (secondRollup.add(sample.timestampUs, code, calibration->version, rollup))
+        batch.rollups.append(rollup);
+    if (minuteRollup.add(sample.timestampUs, code, calibration->version, rollup))
+        batch.rollups.append(rollup);
+
+    batch.samples.append({ sample.timestampUs, sample.code, calibration->version,
+                           c.extracted, c.tared, c.grams, readNs });
+    sampleIndex++;
+}
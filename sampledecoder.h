@@ -0,0 +1,148 @@
+#pragma once
+
+#include <QObject>
+#include <QByteArray>
+#include <QVector>
+#include <atomic>
+#include <string_view>
+
+#include "adctiming.h"
+#include "autozero.h"
+#include "calibration.h"
+#include "checkweigher.h"
+#include "filters.h"
+#include "histogram.h"
+#include "rollups.h"
+#include "stability.h"
+#include "triggerengine.h"
+#include "i2cdecoder.h"
+#include "streamstats.h"
+
+// One sniffer line for the raw view. Lines in the usual layout are carried
+// as their transaction only; anything else (malformed, NACKed, unusual
+// spacing) keeps its trimmed text.
+struct RawLine
+{
+    int64_t timestampUs;
+    I2cTransaction txn;
+    QByteArray text;        // empty when the line is formatTransaction(txn)
+};
+
+struct DecodedSample
+{
+    int64_t timestampUs;
+    uint32_t code;
+    uint32_t calibrationVersion;
+    int64_t extracted;
+    int64_t tared;
+    double grams;
+    qint64 readNs;          // USB read that completed the triplet
+};
+
+// Output of the weight channel filter chain
+struct FilteredSample
+{
+    int64_t timestampUs;
+    double grams;
+    double sigma;       // estimator standard deviation, < 0 if none
+};
+
+// Everything decoded from one USB read
+struct DecodedBatch
+{
+    QVector<RawLine> lines;
+    QVector<DecodedSample> samples;
+    QVector<FilteredSample> filtered;
+    QVector<StabilityEvent> stabilityEvents;
+    QVector<TriggerCapture> captures;       // completed in this batch
+    QVector<Rollup> rollups;                // per-second and per-minute, completed
+    QVector<CheckweighItem> items;          // left the cell in this batch
+
+    // Checkweigher batch statistics, set when 'items' is not empty
+    CheckweighStats checkweigh;
+
+    // Weight distribution, at most every kHistogramIntervalUs; empty otherwise
+    HistogramSnapshot histogram;
+
+    // Noise statistics of the raw codes after the last sample
+    StatsSnapshot countWindow;
+    StatsSnapshot timeWindow;
+
+    AdcTimingSnapshot timing;
+};
+
+Q_DECLARE_METATYPE(DecodedBatch)
+
+// Splits, decodes and converts the byte stream on its own thread and hands
+// the results to the GUI one batch per USB read
+class SampleDecoder : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SampleDecoder(CalibrationRegistry *calibrations, QObject *parent = nullptr);
+
+    void setEnabled(bool on) { enabled.store(on, std::memory_order_relaxed); }
+
+public slots:
+    void onBytes(const QByteArray &data, qint64 readNs);
+    void setStatsWindows(int samples, double seconds);
+    void setFilter(const QString &spec);
+    void setStabilityParameters(const StabilityParameters &params);
+    void configureTrigger(const TriggerSettings &settings);
+    void armTrigger();
+    void configureAutoZero(const AutoZeroSettings &settings);
+    void configureCheckweigher(const CheckweigherSettings &settings);
+    void newCheckweighBatch();
+    void configureHistogram(const HistogramSettings &settings);
+    void resetHistogram();
+
+signals:
+    void batchReady(DecodedBatch batch);
+    void filterChanged(const QString &description, const QString &error);
+    // The filter cannot run at a new conversion rate and is bypassed
+    void filterSuspended(const QString &error);
+
+private:
+    void processLine(std::string_view rawLine, qint64 readNs, int64_t captureUs, DecodedBatch &batch);
+    void applyCtrl2(const I2cTransaction &txn);
+    void setSampleRate(double rateHz);
+    void applyOutputRate();
+    void filterBatch(DecodedBatch &batch);
+
+    CalibrationRegistry *calibrations;
+    std::atomic<bool> enabled{false};
+
+    LineSplitter splitter;
+    TripletAssembler assembler;
+
+    uint64_t sampleIndex = 0;
+    uint32_t lastVersion = 0;
+    AutoZeroTracker autoZero;
+
+    RollupAggregator secondRollup{ 1000000 };
+    RollupAggregator minuteRollup{ 60 * 1000000 };
+
+    SlidingStats countStats;    // last N samples
+    SlidingStats timeStats;     // last T seconds
+
+    // NAU7802 power-on rate (CTRL2 CRS = 10 SPS), updated from CTRL2 reads
+    double sampleRateHz = 10.0;
+    AdcTimingAnalyzer timing;
+
+    // Steady clock to wall clock, fixed at the first batch
+    bool haveWallOffset = false;
+    int64_t wallOffsetUs = 0;
+
+    QString filterSpec;
+    bool filterInvalid = false;     // spec does not fit the current rate
+    FilterChain filter;
+    std::vector<int64_t> filterTimestamps;
+    std::vector<double> filterValues;
+
+    // Runs on the filter output
+    StabilityDetector stability;
+    TriggerEngine trigger;
+    Checkweigher checkweigher;
+    WeightHistogram histogram;
+    int64_t histogramSentUs = 0;
+};
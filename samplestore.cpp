@@ -0,0 +1,207 @@
+#include "samplestore.h"
+
+#include <algorithm>
+
+#include "adcconvert.h"
+
+SampleStore::SampleStore(size_t maxSamples)
+    : maxBlocks(std::max<size_t>(1, (maxSamples + kBlockSize - 1) / kBlockSize))
+{
+    treeLeaves = 1;
+    while (treeLeaves < maxBlocks)
+        treeLeaves <<= 1;
+    tree.assign(2 * treeLeaves, Summary());
+}
+
+void SampleStore::append(int64_t timestampUs, uint32_t code)
+{
+    if (blocks.empty() || blocks.back()->count == kBlockSize) {
+        std::unique_ptr<Block> block;
+        if (blocks.size() == maxBlocks) {
+            block = std::move(blocks.front());
+            blocks.pop_front();
+            setBlockLeaf(block->seq, Summary());
+        }
+        else {
+            block = std::make_unique<Block>();
+        }
+        block->firstIndex = nextIndex;
+        block->seq = nextBlockSeq++;
+        block->count = 0;
+        block->cacheVersion = 0;
+        block->cachedCount = 0;
+        std::fill(std::begin(block->summary), std::end(block->summary), Summary());
+        blocks.push_back(std::move(block));
+    }
+
+    Block &b = *blocks.back();
+    size_t i = b.count++;
+    b.timestampUs[i] = timestampUs;
+    b.code[i] = code;
+    nextIndex++;
+
+    const int32_t value = signExtend24(code);
+    for (int level = 0; level < kLevels; ++level)
+        b.summary[levelOffset(level) + (i >> (kLeafShift + level))].add(value);
+
+    if (b.count == kBlockSize)
+        setBlockLeaf(b.seq, b.summary[kSummaryNodes - 1]);
+}
+
+void SampleStore::setBlockLeaf(uint64_t blockSeq, const Summary &s)
+{
+    size_t node = treeLeaves + size_t(blockSeq % treeLeaves);
+    tree[node] = s;
+    for (node /= 2; node >= 1; node /= 2) {
+        tree[node] = tree[2 * node];
+        tree[node].merge(tree[2 * node + 1]);
+    }
+}
+
+SampleStore::Summary SampleStore::summarizeBlocks(uint64_t fromSeq, uint64_t toSeq) const
+{
+    Summary s;
+
+    auto query = [&](size_t lo, size_t hi) {
+        for (lo += treeLeaves, hi += treeLeaves; lo < hi; lo /= 2, hi /= 2) {
+            if (lo & 1)
+                s.merge(tree[lo++]);
+            if (hi & 1)
+                s.merge(tree[--hi]);
+        }
+    };
+
+    if (toSeq <= fromSeq)
+        return s;
+    size_t first = size_t(fromSeq % treeLeaves);
+    size_t length = size_t(toSeq - fromSeq);
+    if (first + length <= treeLeaves) {
+        query(first, first + length);
+    }
+    else {
+        query(first, treeLeaves);
+        query(0, first + length - treeLeaves);
+    }
+    return s;
+}
+
+SampleStore::Summary SampleStore::summarizeBlock(const Block &block, size_t from, size_t to) const
+{
+    constexpr size_t kLeaf = size_t(1) << kLeafShift;
+    Summary s;
+    size_t p = from;
+
+    // Loose samples up to the first run boundary
+    while (p < to && (p & (kLeaf - 1)))
+        s.add(signExtend24(block.code[p++]));
+
+    // Largest aligned runs that fit
+    while (p + kLeaf <= to) {
+        int level = 0;
+        while (level + 1 < kLevels
+               && (p & ((kLeaf << (level + 1)) - 1)) == 0
+               && p + (kLeaf << (level + 1)) <= to)
+            ++level;
+        s.merge(block.summary[levelOffset(level) + (p >> (kLeafShift + level))]);
+        p += kLeaf << level;
+    }
+
+    while (p < to)
+        s.add(signExtend24(block.code[p++]));
+    return s;
+}
+
+SampleStore::Summary SampleStore::summarize(uint64_t begin, uint64_t end) const
+{
+    begin = std::max(begin, beginIndex());
+    end = std::min(end, endIndex());
+    if (begin >= end)
+        return Summary();
+
+    auto [first, firstOffset] = locate(begin);
+    auto [last, lastOffset] = locate(end - 1);
+    if (first == last)
+        return summarizeBlock(*first, firstOffset, lastOffset + 1);
+
+    Summary s = summarizeBlock(*first, firstOffset, first->count);
+    s.merge(summarizeBlocks(first->seq + 1, last->seq));
+    s.merge(summarizeBlock(*last, 0, lastOffset + 1));
+    return s;
+}
+
+SampleStore::Summary SampleStore::summarizeTime(int64_t fromUs, int64_t toUs) const
+{
+    auto [begin, end] = indexRange(fromUs, toUs);
+    return summarize(begin, end);
+}
+
+std::vector<SampleStore::Summary> SampleStore::levelOfDetail(uint64_t begin, uint64_t end,
+                                                             size_t buckets) const
+{
+    begin = std::max(begin, beginIndex());
+    end = std::max(begin, std::min(end, endIndex()));
+
+    std::vector<SampleStore::Summary> out(buckets);
+    const uint64_t span = end - begin;
+    for (size_t k = 0; k < buckets; ++k) {
+        uint64_t from = begin + span * k / buckets;
+        uint64_t to = begin + span * (k + 1) / buckets;
+        out[k] = summarize(from, to);
+    }
+    return out;
+}
+
+void SampleStore::refresh(const Block &block) const
+{
+    if (!block.tared) {
+        block.tared = std::make_unique<int64_t[]>(kBlockSize);
+        block.scaled = std::make_unique<double[]>(kBlockSize);
+    }
+
+    size_t from = block.cacheVersion == cal.version ? block.cachedCount : 0;
+    if (from == block.count)
+        return;
+
+    convertBatch(block.code + from, block.count - from, cal,
+                 block.tared.get() + from, block.scaled.get() + from);
+    block.cacheVersion = cal.version;
+    block.cachedCount = block.count;
+}
+
+void SampleStore::clear()
+{
+    blocks.clear();
+    std::fill(tree.begin(), tree.end(), Summary());
+}
+
+std::pair<const SampleStore::Block *, size_t> SampleStore::locate(uint64_t index) const
+{
+    // All blocks but the last are full, so this is plain arithmetic
+    uint64_t rel = index - blocks.front()->firstIndex;
+    const Block *block = blocks[size_t(rel / kBlockSize)].get();
+    return { block, size_t(rel % kBlockSize) };
+}
+
+uint64_t SampleStore::lowerBound(int64_t timestampUs) const
+{
+    if (blocks.empty())
+        return nextIndex;
+
+    // Last block starting at or before the timestamp
+    auto it = std::upper_bound(blocks.begin(), blocks.end(), timestampUs,
+        [](int64_t t, const std::unique_ptr<Block> &b) { return t < b->timestampUs[0]; });
+    if (it == blocks.begin())
+        return blocks.front()->firstIndex;
+    --it;
+
+    const Block &b = **it;
+    const int64_t *pos = std::lower_bound(b.timestampUs, b.timestampUs + b.count, timestampUs);
+    return b.firstIndex + (pos - b.timestampUs);
+}
+
+std::pair<uint64_t, uint64_t> SampleStore::indexRange(int64_t fromUs, int64_t toUs) const
+{
+    if (toUs <= fromUs)
+        return { lowerBound(fromUs), lowerBound(fromUs) };
+    return { lowerBound(fromUs), lowerBound(toUs) };
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "calibration.h"
+
+// Columnar history of decoded samples. Samples live in fixed-size blocks
+// holding one contiguous array per column; when the configured capacity is
+// reached the oldest block is recycled. Samples are addressed by a running
+// index that keeps counting across evictions.
+//
+// Only timestamps and raw codes are stored. Tared and scaled values are
+// derived from the current calibration in batches, on first use, and cached
+// per block until the calibration version changes.
+//
+// A min/max/sum pyramid over the sign-extended codes is kept up to date on
+// append: inside each block for runs of 16, 32, ... 4096 samples, and a
+// segment tree over the complete blocks. Any index or time range is
+// summarised from O(log n) nodes. Being in code units, the pyramid stays
+// valid across calibration changes.
+class SampleStore
+{
+public:
+    static constexpr size_t kBlockSize = 4096;
+    static constexpr int kLeafShift = 4;                            // 16 samples
+    static constexpr int kLevels = 9;                               // 16 .. 4096
+    static constexpr size_t kSummaryNodes = (kBlockSize >> (kLeafShift - 1)) - 1;
+
+    // Aggregate of a run of samples, in sign-extended code units
+    struct Summary
+    {
+        uint64_t count = 0;
+        int64_t sum = 0;
+        int32_t min = INT32_MAX;
+        int32_t max = INT32_MIN;
+
+        double mean() const { return count ? double(sum) / double(count) : 0.0; }
+
+        void add(int32_t code)
+        {
+            count++;
+            sum += code;
+            min = std::min(min, code);
+            max = std::max(max, code);
+        }
+        void merge(const Summary &o)
+        {
+            count += o.count;
+            sum += o.sum;
+            min = std::min(min, o.min);
+            max = std::max(max, o.max);
+        }
+    };
+
+    struct Block
+    {
+        uint64_t firstIndex = 0;
+        uint64_t seq = 0;           // running block number
+        size_t count = 0;
+
+        int64_t timestampUs[kBlockSize];
+        uint32_t code[kBlockSize];
+
+        // Derived columns, valid for the first cachedCount samples
+        mutable std::unique_ptr<int64_t[]> tared;
+        mutable std::unique_ptr<double[]> scaled;
+        mutable uint32_t cacheVersion = 0;
+        mutable size_t cachedCount = 0;
+
+        // Pyramid, level l (runs of 16 << l samples) starts at node
+        // levelOffset(l); the nodes of the open run are partial
+        Summary summary[kSummaryNodes];
+    };
+
+    explicit SampleStore(size_t maxSamples = size_t(1) << 23);
+
+    void append(int64_t timestampUs, uint32_t code);
+    void clear();
+
+    // Changes apply to the whole history on the next read
+    void setCalibration(const Calibration &c) { cal = c; }
+    const Calibration &calibration() const { return cal; }
+
+    size_t size() const { return size_t(endIndex() - beginIndex()); }
+    bool empty() const { return blocks.empty(); }
+    size_t capacity() const { return maxBlocks * kBlockSize; }
+
+    // Held samples are [beginIndex(), endIndex())
+    uint64_t beginIndex() const { return blocks.empty() ? nextIndex : blocks.front()->firstIndex; }
+    uint64_t endIndex() const { return nextIndex; }
+
+    int64_t timestampAt(uint64_t index) const { auto [b, i] = locate(index); return b->timestampUs[i]; }
+    uint32_t codeAt(uint64_t index) const { auto [b, i] = locate(index); return b->code[i]; }
+    int64_t taredAt(uint64_t index) const { auto [b, i] = locate(index); return tared(*b)[i]; }
+    double scaledAt(uint64_t index) const { auto [b, i] = locate(index); return scaled(*b)[i]; }
+
+    // Derived columns of a block, recomputed if stale
+    const int64_t *tared(const Block &block) const { refresh(block); return block.tared.get(); }
+    const double *scaled(const Block &block) const { refresh(block); return block.scaled.get(); }
+
+    // Index range of the samples with fromUs <= timestamp < toUs, found by
+    // binary search over the block start times and then within the blocks
+    std::pair<uint64_t, uint64_t> indexRange(int64_t fromUs, int64_t toUs) const;
+
+    // Min/max/sum of the codes in [begin, end) or fromUs <= t < toUs
+    Summary summarize(uint64_t begin, uint64_t end) const;
+    Summary summarizeTime(int64_t fromUs, int64_t toUs) const;
+
+    // Splits [begin, end) into 'buckets' equal runs and summarises each,
+    // e.g. one per plot column at any zoom level
+    std::vector<Summary> levelOfDetail(uint64_t begin, uint64_t end, size_t buckets) const;
+
+    // Calls f(const Block &, size_t offset, size_t count) for the contiguous
+    // pieces of [begin, end), oldest first
+    template <typename F>
+    void forEachSpan(uint64_t begin, uint64_t end, F &&f) const
+    {
+        begin = std::max(begin, beginIndex());
+        end = std::min(end, endIndex());
+        while (begin < end) {
+            auto [block, offset] = locate(begin);
+            size_t count = size_t(std::min<uint64_t>(block->count - offset, end - begin));
+            f(*block, offset, count);
+            begin += count;
+        }
+    }
+
+private:
+    static constexpr size_t levelOffset(int level)
+    {
+        return (kBlockSize >> (kLeafShift - 1)) - (kBlockSize >> (kLeafShift + level - 1));
+    }
+
+    Summary summarizeBlock(const Block &block, size_t from, size_t to) const;
+    void setBlockLeaf(uint64_t blockSeq, const Summary &s);
+    Summary summarizeBlocks(uint64_t fromSeq, uint64_t toSeq) const;
+
+    std::pair<const Block *, size_t> locate(uint64_t index) const;
+    uint64_t lowerBound(int64_t timestampUs) const;
+    void refresh(const Block &block) const;
+
+    Calibration cal;
+    size_t maxBlocks;
+    uint64_t nextIndex = 0;
+    uint64_t nextBlockSeq = 0;
+    std::deque<std::unique_ptr<Block>> blocks;
+
+    // Segment tree over complete blocks, leaf = block number % treeLeaves
+    size_t treeLeaves;
+    std::vector<Summary> tree;
+};
@@ -0,0 +1,174 @@
+#include "spc.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// X-bar/R chart constants for subgroup sizes 2 .. 10
+struct ChartConstants
+{
+    double a2, d3, d4, d2;
+};
+
+constexpr ChartConstants kConstants[] = {
+    { 1.880, 0.000, 3.267, 1.128 },
+    { 1.023, 0.000, 2.574, 1.693 },
+    { 0.729, 0.000, 2.282, 2.059 },
+    { 0.577, 0.000, 2.114, 2.326 },
+    { 0.483, 0.000, 2.004, 2.534 },
+    { 0.419, 0.076, 1.924, 2.704 },
+    { 0.373, 0.136, 1.864, 2.847 },
+    { 0.337, 0.184, 1.816, 2.970 },
+    { 0.308, 0.223, 1.777, 3.078 },
+};
+
+constexpr size_t kMinSubgroup = 2;
+constexpr size_t kMaxSubgroup = 10;
+
+// Longest run the Western Electric rules look back over
+constexpr size_t kRuleHistory = 8;
+
+// Whether at least 'need' of the last 'of' values lie beyond 'zone' on one side
+bool beyond(const RingDeque<double> &recent, size_t need, size_t of, double zone)
+{
+    if (recent.size() < need)
+        return false;
+    size_t above = 0;
+    size_t below = 0;
+    size_t n = std::min(of, recent.size());
+    for (size_t i = recent.size() - n; i < recent.size(); ++i) {
+        above += recent[i] > zone;
+        below += recent[i] < -zone;
+    }
+    return above >= need || below >= need;
+}
+
+} // namespace
+
+SpcChart::SpcChart(const SpcSettings &settings)
+{
+    configure(settings);
+}
+
+void SpcChart::configure(const SpcSettings &settings)
+{
+    cfg = settings;
+    cfg.subgroupSize = std::clamp(cfg.subgroupSize, kMinSubgroup, kMaxSubgroup);
+    cfg.baselineSubgroups = std::max<size_t>(cfg.baselineSubgroups, 2);
+    reset();
+}
+
+void SpcChart::reset()
+{
+    lim = SpcLimits();
+    filled = 0;
+    baselineCount = 0;
+    baselineMeans = baselineRanges = 0.0;
+    recent.clear();
+    cusumHigh = cusumLow = 0.0;
+    nextSubgroup = 1;
+    violated = 0;
+    history.clear();
+}
+
+const char *SpcChart::describe(SpcPoint::Violation v)
+{
+    switch (v) {
+    case SpcPoint::Beyond3Sigma: return "beyond 3 sigma";
+    case SpcPoint::TwoOfThree: return "2 of 3 beyond 2 sigma";
+    case SpcPoint::FourOfFive: return "4 of 5 beyond 1 sigma";
+    case SpcPoint::EightOneSide: return "8 in a row on one side";
+    case SpcPoint::RangeOut: return "range out of limits";
+    case SpcPoint::CusumHigh: return "CUSUM shift up";
+    case SpcPoint::CusumLow: return "CUSUM shift down";
+    }
+    return "";
+}
+
+bool SpcChart::add(int64_t timestampUs, double weight, SpcPoint &point)
+{
+    if (filled == 0) {
+        sum = 0.0;
+        lo = hi = weight;
+    }
+    sum += weight;
+    lo = std::min(lo, weight);
+    hi = std::max(hi, weight);
+    if (++filled < cfg.subgroupSize)
+        return false;
+    filled = 0;
+
+    point.subgroup = nextSubgroup++;
+    point.timestampUs = timestampUs;
+    point.mean = sum / double(cfg.subgroupSize);
+    point.range = hi - lo;
+    point.cusumHigh = point.cusumLow = 0.0;
+    point.violations = 0;
+
+    if (lim.valid) {
+        evaluate(point);
+    }
+    else {
+        baselineCount++;
+        baselineMeans += point.mean;
+        baselineRanges += point.range;
+        if (baselineCount == cfg.baselineSubgroups) {
+            const ChartConstants &k = kConstants[cfg.subgroupSize - kMinSubgroup];
+            const double rbar = baselineRanges / double(baselineCount);
+            lim.center = baselineMeans / double(baselineCount);
+            lim.ucl = lim.center + k.a2 * rbar;
+            lim.lcl = lim.center - k.a2 * rbar;
+            lim.rangeCenter = rbar;
+            lim.rangeUcl = k.d4 * rbar;
+            lim.rangeLcl = k.d3 * rbar;
+            lim.sigmaMean = k.a2 * rbar / 3.0;
+            lim.valid = true;
+        }
+    }
+
+    violated += point.violations != 0;
+    history.push_back(point);
+    if (history.size() > kMaxPoints)
+        history.pop_front();
+    return true;
+}
+
+void SpcChart::evaluate(SpcPoint &point)
+{
+    // A zero-width baseline cannot be judged in sigma units
+    if (lim.sigmaMean <= 0.0)
+        return;
+
+    uint8_t v = 0;
+    const double z = (point.mean - lim.center) / lim.sigmaMean;
+    recent.push_back(z);
+    if (recent.size() > kRuleHistory)
+        recent.pop_front();
+
+    if (std::fabs(z) > 3.0)
+        v |= SpcPoint::Beyond3Sigma;
+    if (beyond(recent, 2, 3, 2.0))
+        v |= SpcPoint::TwoOfThree;
+    if (beyond(recent, 4, 5, 1.0))
+        v |= SpcPoint::FourOfFive;
+    if (beyond(recent, 8, 8, 0.0))
+        v |= SpcPoint::EightOneSide;
+    if (point.range > lim.rangeUcl || point.range < lim.rangeLcl)
+        v |= SpcPoint::RangeOut;
+
+    // Tabular CUSUM on the standardised mean, restarted after a signal
+    cusumHigh = std::max(0.0, cusumHigh + z - cfg.cusumK);
+    cusumLow = std::max(0.0, cusumLow - z - cfg.cusumK);
+    point.cusumHigh = cusumHigh;
+    point.cusumLow = cusumLow;
+    if (cusumHigh > cfg.cusumH) {
+        v |= SpcPoint::CusumHigh;
+        cusumHigh = 0.0;
+    }
+    if (cusumLow > cfg.cusumH) {
+        v |= SpcPoint::CusumLow;
+        cusumLow = 0.0;
+    }
+    point.violations = v;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "ringdeque.h"
+
+struct SpcSettings
+{
+    size_t subgroupSize = 5;        // 2 .. 10
+    size_t baselineSubgroups = 20;  // subgroups that set the control limits
+    double cusumK = 0.5;            // allowance, in sigma of the subgroup mean
+    double cusumH = 5.0;            // decision interval, same unit
+};
+
+// Control limits from the baseline, fixed once it is complete
+struct SpcLimits
+{
+    bool valid = false;
+    double center = 0.0;
+    double ucl = 0.0;
+    double lcl = 0.0;
+    double rangeCenter = 0.0;
+    double rangeUcl = 0.0;
+    double rangeLcl = 0.0;
+    double sigmaMean = 0.0;         // of the subgroup mean, (ucl - center) / 3
+};
+
+// One completed subgroup with everything a chart needs to draw it
+struct SpcPoint
+{
+    enum Violation : uint8_t
+    {
+        Beyond3Sigma  = 1 << 0,     // Western Electric rule 1
+        TwoOfThree    = 1 << 1,     // rule 2: 2 of 3 beyond 2 sigma, same side
+        FourOfFive    = 1 << 2,     // rule 3: 4 of 5 beyond 1 sigma, same side
+        EightOneSide  = 1 << 3,     // rule 4: 8 in a row on one side
+        RangeOut      = 1 << 4,     // range outside its limits
+        CusumHigh     = 1 << 5,
+        CusumLow      = 1 << 6,
+    };
+
+    uint64_t subgroup;
+    int64_t timestampUs;            // last item of the subgroup
+    double mean;
+    double range;
+    double cusumHigh;               // in sigma of the mean
+    double cusumLow;
+    uint8_t violations;
+};
+
+// X-bar/R and tabular CUSUM of item weights, maintained as items arrive.
+// Points are computed once per subgroup and kept in a bounded history, so
+// charts only draw precomputed values. Limits come from the first
+// baselineSubgroups subgroups (Rbar/d2 estimate of sigma); rules and
+// CUSUM are evaluated from then on.
+class SpcChart
+{
+public:
+    static constexpr size_t kMaxPoints = 1000;
+
+    explicit SpcChart(const SpcSettings &settings = SpcSettings());
+
+    void configure(const SpcSettings &settings);
+    const SpcSettings &settings() const { return cfg; }
+
+    // Restarts the baseline and clears the history
+    void reset();
+
+    // Returns true and fills 'point' when the item completes a subgroup
+    bool add(int64_t timestampUs, double weight, SpcPoint &point);
+
+    const SpcLimits &limits() const { return lim; }
+    const RingDeque<SpcPoint> &points() const { return history; }
+    uint64_t violationCount() const { return violated; }
+
+    static const char *describe(SpcPoint::Violation v);
+
+private:
+    void evaluate(SpcPoint &point);
+
+    SpcSettings cfg;
+    SpcLimits lim;
+
+    // Subgroup being filled
+    size_t filled = 0;
+    double sum = 0.0;
+    double lo = 0.0;
+    double hi = 0.0;
+
+    // Baseline sums
+    size_t baselineCount = 0;
+    double baselineMeans = 0.0;
+    double baselineRanges = 0.0;
+
+    // Recent means in sigma units from the center, newest last
+    RingDeque<double> recent;
+    double cusumHigh = 0.0;
+    double cusumLow = 0.0;
+
+    uint64_t nextSubgroup = 1;
+    uint64_t violated = 0;
+    RingDeque<SpcPoint> history;
+};
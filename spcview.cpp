@@ -0,0 +1,99 @@
+#include "spcview.h"
+
+#include <QPainter>
+#include <algorithm>
+#include <initializer_list>
+
+namespace {
+
+constexpr int kPointSpacing = 4;    // pixels per subgroup
+
+} // namespace
+
+SpcView::SpcView(const SpcChart *chart, QWidget *parent)
+    : QWidget(parent),
+      chart(chart)
+{
+    setMinimumHeight(90);
+}
+
+void SpcView::paintEvent(QPaintEvent *)
+{
+    QPainter painter(this);
+    painter.fillRect(rect(), palette().base());
+
+    const RingDeque<SpcPoint> &points = chart->points();
+    const SpcLimits &lim = chart->limits();
+    const QFontMetrics fm = painter.fontMetrics();
+    const QRect area = rect().adjusted(fm.horizontalAdvance("CUSUM") + 8, 4, -4, -4);
+
+    if (points.empty() || area.width() < kPointSpacing || area.height() < 30) {
+        painter.setPen(palette().color(QPalette::Text));
+        painter.drawText(area, Qt::AlignCenter, "SPC: waiting for items");
+        return;
+    }
+
+    const size_t visible = std::min(points.size(), size_t(area.width() / kPointSpacing));
+    const size_t first = points.size() - visible;
+    auto xAt = [&](size_t i) { return area.left() + double(i - first) * kPointSpacing; };
+
+    const int stripHeight = area.height() / 3;
+    const QColor lineColor = palette().color(QPalette::Highlight);
+    const QColor limitColor = palette().color(QPalette::Mid);
+
+    // One strip: series from 'value', dashed limit lines, violating points in red
+    auto strip = [&](int row, const char *label, auto value, std::initializer_list<double> lines,
+                     uint8_t flags) {
+        const QRect r(area.left(), area.top() + row * stripHeight, area.width(), stripHeight - 2);
+        double lo = *std::min_element(lines.begin(), lines.end());
+        double hi = *std::max_element(lines.begin(), lines.end());
+        for (size_t i = first; i < points.size(); ++i) {
+            lo = std::min(lo, value(points[i]));
+            hi = std::max(hi, value(points[i]));
+        }
+        if (hi <= lo)
+            hi = lo + 1.0;
+        auto yAt = [&](double v) { return r.bottom() - (v - lo) / (hi - lo) * r.height(); };
+
+        painter.setPen(palette().color(QPalette::Text));
+        painter.drawText(QRect(0, r.top(), area.left() - 4, r.height()), Qt::AlignRight | Qt::AlignVCenter,
+                         label);
+
+        painter.setPen(QPen(limitColor, 1.0, Qt::DashLine));
+        for (double l : lines)
+            painter.drawLine(QPointF(r.left(), yAt(l)), QPointF(r.right(), yAt(l)));
+
+        painter.setPen(QPen(lineColor, 1.0));
+        for (size_t i = first + 1; i < points.size(); ++i)
+            painter.drawLine(QPointF(xAt(i - 1), yAt(value(points[i - 1]))),
+                             QPointF(xAt(i), yAt(value(points[i]))));
+
+        painter.setPen(Qt::NoPen);
+        painter.setBrush(Qt::red);
+        for (size_t i = first; i < points.size(); ++i) {
+            if (points[i].violations & flags)
+                painter.drawEllipse(QPointF(xAt(i), yAt(value(points[i]))), 2.5, 2.5);
+        }
+        painter.setBrush(Qt::NoBrush);
+    };
+
+    const uint8_t meanRules = SpcPoint::Beyond3Sigma | SpcPoint::TwoOfThree | SpcPoint::FourOfFive
+                              | SpcPoint::EightOneSide;
+    const double h = chart->settings().cusumH;
+
+    painter.setRenderHint(QPainter::Antialiasing);
+    if (lim.valid) {
+        strip(0, "X-bar", [](const SpcPoint &p) { return p.mean; }, { lim.lcl, lim.center, lim.ucl }, meanRules);
+        strip(1, "R", [](const SpcPoint &p) { return p.range; },
+              { lim.rangeLcl, lim.rangeCenter, lim.rangeUcl }, SpcPoint::RangeOut);
+    }
+    else {
+        // Baseline still running: plot without limits
+        const double m = points.back().mean;
+        const double r = points.back().range;
+        strip(0, "X-bar", [](const SpcPoint &p) { return p.mean; }, { m }, 0);
+        strip(1, "R", [](const SpcPoint &p) { return p.range; }, { r }, 0);
+    }
+    strip(2, "CUSUM", [](const SpcPoint &p) { return std::max(p.cusumHigh, p.cusumLow); }, { 0.0, h },
+          SpcPoint::CusumHigh | SpcPoint::CusumLow);
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <QWidget>
+
+#include "spc.h"
+
+// X-bar, R and CUSUM strips of an SpcChart. Paints the newest points that
+// fit the width straight from the chart's history; nothing is recomputed.
+class SpcView : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit SpcView(const SpcChart *chart, QWidget *parent = nullptr);
+
+    QSize sizeHint() const override { return QSize(400, 140); }
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    const SpcChart *chart;
+};
@@ -0,0 +1,107 @@
+#include "spectrum.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include "flightrecorder.h"
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+
+} // namespace
+
+void fftRadix2(std::complex<double> *data, size_t n, const std::complex<double> *twiddles)
+{
+    // Bit-reversal permutation
+    for (size_t i = 1, j = 0; i < n; ++i) {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1)
+            j ^= bit;
+        j |= bit;
+        if (i < j)
+            std::swap(data[i], data[j]);
+    }
+
+    // Butterflies, the twiddle stride halving with each stage
+    for (size_t half = 1, stride = n / 2; half < n; half <<= 1, stride >>= 1) {
+        for (size_t start = 0; start < n; start += 2 * half) {
+            for (size_t k = 0; k < half; ++k) {
+                std::complex<double> t = twiddles[k * stride] * data[start + half + k];
+                data[start + half + k] = data[start + k] - t;
+                data[start + k] += t;
+            }
+        }
+    }
+}
+
+SpectrumAnalyzer::SpectrumAnalyzer(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void SpectrumAnalyzer::prepare(size_t length)
+{
+    if (window.size() == length)
+        return;
+
+    window.resize(length);
+    windowPower = 0.0;
+    for (size_t i = 0; i < length; ++i) {
+        window[i] = 0.5 - 0.5 * std::cos(2.0 * kPi * double(i) / double(length));
+        windowPower += window[i] * window[i];
+    }
+
+    twiddles.resize(length / 2);
+    for (size_t k = 0; k < length / 2; ++k)
+        twiddles[k] = std::polar(1.0, -2.0 * kPi * double(k) / double(length));
+
+    work.resize(length);
+}
+
+void SpectrumAnalyzer::reset()
+{
+    average = Spectrum();
+}
+
+void SpectrumAnalyzer::analyze(const QVector<double> &block, double sampleRateHz,
+                               uint64_t generation)
+{
+    const size_t n = size_t(block.size());
+    if (n < 2 || (n & (n - 1)) || sampleRateHz <= 0.0)
+        return;
+
+    TraceSpan span("spectrum", qint64(n));
+
+    if (n != average.length || std::fabs(sampleRateHz - average.sampleRateHz) > 0.01 * sampleRateHz) {
+        average = Spectrum();
+        average.length = n;
+        average.sampleRateHz = sampleRateHz;
+        average.power.assign(n / 2 + 1, 0.0);
+    }
+    prepare(n);
+
+    double mean = 0.0;
+    for (double v : block)
+        mean += v;
+    mean /= double(n);
+
+    for (size_t i = 0; i < n; ++i)
+        work[i] = std::complex<double>((block[i] - mean) * window[i], 0.0);
+    fftRadix2(work.data(), n, twiddles.data());
+
+    // One-sided density: interior bins carry both halves of the spectrum
+    average.averages++;
+    const double weight = 1.0 / double(std::min(average.averages, kMaxAverages));
+    const double scale = 1.0 / (sampleRateHz * windowPower);
+    for (size_t k = 0; k <= n / 2; ++k) {
+        double p = std::norm(work[k]) * scale;
+        if (k != 0 && k != n / 2)
+            p *= 2.0;
+        average.power[k] += (p - average.power[k]) * weight;
+    }
+
+    average.generation = generation;
+    emit spectrumReady(average);
+}
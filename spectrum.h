@@ -0,0 +1,61 @@
+#pragma once
+
+#include <QObject>
+#include <QMetaType>
+#include <QVector>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Iterative in-place radix-2 FFT. 'n' must be a power of two; twiddles
+// holds exp(-2 pi i k / n) for k < n/2.
+void fftRadix2(std::complex<double> *data, size_t n, const std::complex<double> *twiddles);
+
+// Averaged one-sided power spectral density of the raw codes, in
+// counts^2/Hz for the bins 0 .. length/2, binHz() apart
+struct Spectrum
+{
+    double sampleRateHz = 0.0;
+    size_t length = 0;
+    uint64_t averages = 0;
+    uint64_t generation = 0;        // of the request that produced it
+    std::vector<double> power;
+
+    double binHz() const { return length ? sampleRateHz / double(length) : 0.0; }
+};
+
+Q_DECLARE_METATYPE(Spectrum)
+
+// Welch averaging of Hann windowed, mean removed blocks. Runs on its own
+// thread; the GUI hands it copies of store blocks, so acquisition never
+// waits for it. The first kMaxAverages blocks are averaged evenly, later
+// ones exponentially with the same weight so the view follows changes.
+class SpectrumAnalyzer : public QObject
+{
+    Q_OBJECT
+public:
+    static constexpr uint64_t kMaxAverages = 64;
+
+    explicit SpectrumAnalyzer(QObject *parent = nullptr);
+
+public slots:
+    // A block of sign-extended codes, a power of two long, equally spaced
+    // at 'sampleRateHz'. A different length or rate restarts the average.
+    // 'generation' is handed back with the result so the caller can drop
+    // results of requests made before a reset.
+    void analyze(const QVector<double> &block, double sampleRateHz, uint64_t generation);
+    void reset();
+
+signals:
+    void spectrumReady(const Spectrum &spectrum);
+
+private:
+    void prepare(size_t length);
+
+    Spectrum average;
+    std::vector<double> window;
+    double windowPower = 0.0;       // sum of window^2
+    std::vector<std::complex<double>> twiddles;
+    std::vector<std::complex<double>> work;
+};
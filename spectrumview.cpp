@@ -0,0 +1,96 @@
+#include "spectrumview.h"
+
+#include <QPainter>
+#include <QPainterPath>
+#include <algorithm>
+#include <cmath>
+
+SpectrumView::SpectrumView(QWidget *parent)
+    : QWidget(parent)
+{
+    setMinimumHeight(90);
+}
+
+void SpectrumView::setSpectrum(const Spectrum &s)
+{
+    spectrum = s;
+    update();
+}
+
+void SpectrumView::clear()
+{
+    spectrum = Spectrum();
+    update();
+}
+
+void SpectrumView::paintEvent(QPaintEvent *)
+{
+    QPainter painter(this);
+    painter.fillRect(rect(), palette().base());
+
+    const QFontMetrics fm = painter.fontMetrics();
+    const QRect plot = rect().adjusted(fm.horizontalAdvance("-000 dB") + 6, 6, -8, -fm.height() - 6);
+
+    painter.setPen(palette().color(QPalette::Mid));
+    painter.drawRect(plot);
+
+    const std::vector<double> &power = spectrum.power;
+    if (power.size() < 3 || plot.width() < 2 || plot.height() < 2) {
+        painter.setPen(palette().color(QPalette::Text));
+        painter.drawText(plot, Qt::AlignCenter, "Spectrum: waiting for samples");
+        return;
+    }
+
+    // Amplitude density in dB; DC is left out of the scale
+    auto dB = [](double p) { return 10.0 * std::log10(std::max(p, 1e-12)); };
+    double lo = dB(power[1]);
+    double hi = lo;
+    size_t peak = 1;
+    for (size_t k = 1; k < power.size(); ++k) {
+        double v = dB(power[k]);
+        lo = std::min(lo, v);
+        hi = std::max(hi, v);
+        if (power[k] > power[peak])
+            peak = k;
+    }
+    lo = std::floor(lo / 10.0) * 10.0;
+    hi = std::max(std::ceil(hi / 10.0) * 10.0, lo + 10.0);
+
+    const size_t last = power.size() - 1;
+    auto xAt = [&](size_t k) { return plot.left() + plot.width() * double(k) / double(last); };
+    auto yAt = [&](double v) { return plot.bottom() - plot.height() * (v - lo) / (hi - lo); };
+
+    painter.setPen(palette().color(QPalette::Text));
+    painter.drawText(QRect(0, plot.top() - fm.height() / 2, plot.left() - 4, fm.height()),
+                     Qt::AlignRight, QString("%1 dB").arg(hi, 0, 'f', 0));
+    painter.drawText(QRect(0, plot.bottom() - fm.height() / 2, plot.left() - 4, fm.height()),
+                     Qt::AlignRight, QString("%1 dB").arg(lo, 0, 'f', 0));
+    painter.drawText(QRect(plot.left(), plot.bottom() + 2, plot.width(), fm.height()),
+                     Qt::AlignLeft, "0 Hz");
+    painter.drawText(QRect(plot.left(), plot.bottom() + 2, plot.width(), fm.height()),
+                     Qt::AlignRight, QString("%1 Hz").arg(spectrum.sampleRateHz / 2.0, 0, 'f', 1));
+    painter.drawText(QRect(plot.left(), plot.bottom() + 2, plot.width(), fm.height()), Qt::AlignHCenter,
+                     QString("peak %1 Hz, %2 averages").arg(double(peak) * spectrum.binHz(), 0, 'f', 2)
+                         .arg(spectrum.averages));
+
+    // Bins beyond the plot width are reduced to their maximum per column
+    QPainterPath path;
+    const size_t perColumn = std::max<size_t>(1, last / size_t(plot.width()));
+    for (size_t k = 1; k <= last; k += perColumn) {
+        double v = dB(power[k]);
+        for (size_t j = k + 1; j < std::min(k + perColumn, last + 1); ++j)
+            v = std::max(v, dB(power[j]));
+        QPointF p(xAt(k), yAt(v));
+        if (k == 1)
+            path.moveTo(p);
+        else
+            path.lineTo(p);
+    }
+
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(QPen(palette().color(QPalette::Highlight), 1.0));
+    painter.drawPath(path);
+
+    painter.setPen(QPen(Qt::red, 1.0, Qt::DashLine));
+    painter.drawLine(QPointF(xAt(peak), plot.top()), QPointF(xAt(peak), plot.bottom()));
+}
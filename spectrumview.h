@@ -0,0 +1,25 @@
+#pragma once
+
+#include <QWidget>
+
+#include "spectrum.h"
+
+// Plots a Spectrum as amplitude density in dB re 1 count/sqrt(Hz) over
+// 0 .. fs/2 and marks the strongest bin above DC
+class SpectrumView : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit SpectrumView(QWidget *parent = nullptr);
+
+    void setSpectrum(const Spectrum &spectrum);
+    void clear();
+
+    QSize sizeHint() const override { return QSize(400, 140); }
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    Spectrum spectrum;
+};
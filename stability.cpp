@@ -0,0 +1,136 @@
+#include "stability.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Thresholds are relaxed by this factor to leave the stable state, so a
+// reading right at a limit does not toggle
+constexpr double kHysteresis = 1.5;
+
+} // namespace
+
+StabilityDetector::StabilityDetector(const StabilityParameters &params)
+    : params(params)
+{
+    this->params.window = std::max<size_t>(params.window, 2);
+}
+
+void StabilityDetector::setParameters(const StabilityParameters &p)
+{
+    params = p;
+    params.window = std::max<size_t>(params.window, 2);
+    reset();
+}
+
+void StabilityDetector::reset()
+{
+    window.clear();
+    reference = 0.0;
+    sumY = sumYY = sumXY = 0.0;
+    sinceReseed = 0;
+    stable = false;
+    haveMotionStart = false;
+}
+
+double StabilityDetector::mean() const
+{
+    return window.empty() ? 0.0 : reference + sumY / double(window.size());
+}
+
+double StabilityDetector::stddev() const
+{
+    size_t n = window.size();
+    if (n < 2)
+        return 0.0;
+    double var = (sumYY - sumY * sumY / double(n)) / double(n - 1);
+    return var > 0.0 ? std::sqrt(var) : 0.0;
+}
+
+double StabilityDetector::slope() const
+{
+    double n = double(window.size());
+    if (n < 2)
+        return 0.0;
+    double sumX = n * (n - 1) / 2;
+    double sumXX = (n - 1) * n * (2 * n - 1) / 6;
+    double perSample = (n * sumXY - sumX * sumY) / (n * sumXX - sumX * sumX);
+    return perSample * params.sampleRateHz;
+}
+
+bool StabilityDetector::add(int64_t timestampUs, double value, StabilityEvent &event)
+{
+    if (!haveMotionStart) {
+        motionSinceUs = timestampUs;
+        haveMotionStart = true;
+    }
+    if (window.empty())
+        reference = value;
+
+    double y = value - reference;
+    sumXY += double(window.size()) * y;
+    sumY += y;
+    sumYY += y * y;
+    window.push_back({ timestampUs, y });
+
+    if (window.size() > params.window)
+        removeOldest();
+    if (++sinceReseed >= params.window)
+        reseed();
+
+    if (window.size() < params.window)
+        return false;
+
+    double sd = stddev();
+    double rate = std::fabs(slope());
+    double limit = stable ? kHysteresis : 1.0;
+    bool nowStable = sd <= params.maxStddev * limit && rate <= params.maxSlope * limit;
+    if (nowStable == stable)
+        return false;
+
+    stable = nowStable;
+    event.timestampUs = timestampUs;
+    event.value = mean();
+    event.stddev = sd;
+    if (stable) {
+        event.kind = StabilityEvent::Stable;
+        event.settlingUs = std::max<int64_t>(window.front().timestampUs - motionSinceUs, 0);
+    }
+    else {
+        event.kind = StabilityEvent::Motion;
+        event.settlingUs = 0;
+        motionSinceUs = timestampUs;
+    }
+    return true;
+}
+
+void StabilityDetector::removeOldest()
+{
+    double y0 = window.front().value;
+    window.pop_front();
+    sumY -= y0;
+    sumYY -= y0 * y0;
+    // Every remaining sample moves one position towards the front
+    sumXY -= sumY;
+}
+
+void StabilityDetector::reseed()
+{
+    // Once per window: re-centre on the oldest value and recompute the sums
+    // so cancellation and rounding cannot build up
+    sinceReseed = 0;
+    if (window.empty())
+        return;
+
+    double shift = window.front().value;
+    reference += shift;
+    sumY = sumYY = sumXY = 0.0;
+    for (size_t i = 0; i < window.size(); ++i) {
+        Entry &e = window[i];
+        e.value -= shift;
+        sumY += e.value;
+        sumYY += e.value * e.value;
+        sumXY += double(i) * e.value;
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "ringdeque.h"
+
+struct StabilityEvent
+{
+    enum Kind : uint8_t { Stable, Motion };
+
+    Kind kind;
+    int64_t timestampUs;    // sample that completed the decision
+    double value;           // window mean, the settled value for Stable
+    double stddev;
+    int64_t settlingUs;     // Stable only: motion onset to start of the settled window
+};
+
+struct StabilityParameters
+{
+    size_t window = 16;             // samples
+    double maxStddev = 0.05;        // scaled units
+    double maxSlope = 0.1;          // scaled units per second
+    double sampleRateHz = 10.0;
+};
+
+// Streaming settle detector: a reading is stable while the standard
+// deviation and the least-squares slope over the last N samples are both
+// below their thresholds. Window sums are updated per sample, history is
+// never rescanned.
+class StabilityDetector
+{
+public:
+    explicit StabilityDetector(const StabilityParameters &params = StabilityParameters());
+
+    void setParameters(const StabilityParameters &params);
+    const StabilityParameters &parameters() const { return params; }
+
+    // Only rescales the slope; the window and state are kept
+    void setSampleRate(double rateHz) { params.sampleRateHz = rateHz; }
+
+    // Returns true and fills 'event' on a stable/motion transition
+    bool add(int64_t timestampUs, double value, StabilityEvent &event);
+    void reset();
+
+    bool isStable() const { return stable; }
+    double mean() const;
+    double stddev() const;
+    double slope() const;   // per second
+
+private:
+    struct Entry
+    {
+        int64_t timestampUs;
+        double value;       // relative to 'reference'
+    };
+
+    void removeOldest();
+    void reseed();
+
+    StabilityParameters params;
+
+    RingDeque<Entry> window;
+    double reference = 0.0;
+    double sumY = 0.0;
+    double sumYY = 0.0;
+    double sumXY = 0.0;     // x = position in the window
+    size_t sinceReseed = 0;
+
+    bool stable = false;
+    bool haveMotionStart = false;
+    int64_t motionSinceUs = 0;
+};
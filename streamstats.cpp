@@ -0,0 +1,124 @@
+#include "streamstats.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr double kFullScale = double(1 << 24);
+
+// Welford removal slowly accumulates rounding error, recompute now and then
+constexpr uint64_t kReseedInterval = 1 << 20;
+
+} // namespace
+
+double StatsSnapshot::effectiveBits() const
+{
+    return stddev > 0.0 ? std::log2(kFullScale / stddev) : 24.0;
+}
+
+double StatsSnapshot::noiseFreeBits() const
+{
+    return stddev > 0.0 ? std::log2(kFullScale / (6.6 * stddev)) : 24.0;
+}
+
+SlidingStats::SlidingStats(size_t maxCount, int64_t maxAgeUs)
+    : maxCount(maxCount), maxAgeUs(maxAgeUs)
+{
+}
+
+void SlidingStats::setWindow(size_t count, int64_t ageUs)
+{
+    maxCount = count;
+    maxAgeUs = ageUs;
+    clear();
+}
+
+void SlidingStats::clear()
+{
+    window.clear();
+    minQueue.clear();
+    maxQueue.clear();
+    mean = 0.0;
+    m2 = 0.0;
+    removalsSinceReseed = 0;
+}
+
+void SlidingStats::add(int64_t timestampUs, double value)
+{
+    Entry e{ nextSeq++, timestampUs, value };
+    window.push_back(e);
+
+    double n = double(window.size());
+    double d = value - mean;
+    mean += d / n;
+    m2 += d * (value - mean);
+
+    while (!minQueue.empty() && minQueue.back().value >= value)
+        minQueue.pop_back();
+    minQueue.push_back(e);
+    while (!maxQueue.empty() && maxQueue.back().value <= value)
+        maxQueue.pop_back();
+    maxQueue.push_back(e);
+
+    while (maxCount && window.size() > maxCount)
+        removeOldest();
+    while (maxAgeUs && window.size() > 1 && timestampUs - window.front().timestampUs > maxAgeUs)
+        removeOldest();
+
+    if (removalsSinceReseed >= kReseedInterval)
+        reseed();
+}
+
+void SlidingStats::removeOldest()
+{
+    Entry e = window.front();
+    window.pop_front();
+
+    if (window.empty()) {
+        mean = 0.0;
+        m2 = 0.0;
+    }
+    else {
+        double n = double(window.size());
+        double d = e.value - mean;
+        mean -= d / n;
+        m2 -= d * (e.value - mean);
+    }
+
+    if (minQueue.front().seq == e.seq)
+        minQueue.pop_front();
+    if (maxQueue.front().seq == e.seq)
+        maxQueue.pop_front();
+
+    removalsSinceReseed++;
+}
+
+void SlidingStats::reseed()
+{
+    double sum = 0.0;
+    for (size_t i = 0; i < window.size(); ++i)
+        sum += window[i].value;
+    mean = sum / double(window.size());
+
+    m2 = 0.0;
+    for (size_t i = 0; i < window.size(); ++i) {
+        double d = window[i].value - mean;
+        m2 += d * d;
+    }
+    removalsSinceReseed = 0;
+}
+
+StatsSnapshot SlidingStats::snapshot() const
+{
+    StatsSnapshot s;
+    s.count = window.size();
+    if (!s.count)
+        return s;
+
+    s.mean = mean;
+    s.stddev = s.count > 1 ? std::sqrt(std::max(m2, 0.0) / double(s.count - 1)) : 0.0;
+    s.min = minQueue.front().value;
+    s.max = maxQueue.front().value;
+    return s;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "ringdeque.h"
+
+struct StatsSnapshot
+{
+    size_t count = 0;
+    double mean = 0.0;
+    double stddev = 0.0;
+    double min = 0.0;
+    double max = 0.0;
+
+    double peakToPeak() const { return max - min; }
+
+    // Noise figures for a 24-bit converter, from the RMS noise in codes
+    double effectiveBits() const;
+    double noiseFreeBits() const;       // peak-to-peak taken as 6.6 sigma
+};
+
+// Mean, variance and min/max over a sliding window bounded by sample
+// count and/or age. Each sample costs O(1) amortised: Welford updates for
+// add and remove, monotonic deques for min and max.
+class SlidingStats
+{
+public:
+    // 0 disables the respective bound
+    explicit SlidingStats(size_t maxCount = 0, int64_t maxAgeUs = 0);
+
+    void setWindow(size_t maxCount, int64_t maxAgeUs);
+    void add(int64_t timestampUs, double value);
+    void clear();
+
+    StatsSnapshot snapshot() const;
+
+private:
+    struct Entry
+    {
+        uint64_t seq;
+        int64_t timestampUs;
+        double value;
+    };
+
+    void removeOldest();
+    void reseed();
+
+    size_t maxCount;
+    int64_t maxAgeUs;
+
+    RingDeque<Entry> window;
+    RingDeque<Entry> minQueue;      // increasing values
+    RingDeque<Entry> maxQueue;      // decreasing values
+    uint64_t nextSeq = 0;
+
+    double mean = 0.0;
+    double m2 = 0.0;
+    uint64_t removalsSinceReseed = 0;
+};
@@ -0,0 +1,49 @@
+#include "textformat.h"
+
+#include <QDateTime>
+#include <charconv>
+#include <cstring>
+
+char *formatInt(char *out, int64_t value)
+{
+    return std::to_chars(out, out + kMaxNumber, value).ptr;
+}
+
+char *formatFixed(char *out, double value, int decimals)
+{
+    auto res = std::to_chars(out, out + kMaxNumber, value, std::chars_format::fixed, decimals);
+    if (res.ec != std::errc())
+        res = std::to_chars(out, out + kMaxNumber, value);
+    return res.ptr;
+}
+
+char *TimestampFormatter::format(char *out, int64_t msSinceEpoch)
+{
+    int64_t second = msSinceEpoch / 1000;
+    int ms = int(msSinceEpoch % 1000);
+    if (ms < 0) {
+        second--;
+        ms += 1000;
+    }
+
+    if (second != cachedSecond) {
+        QTime t = QDateTime::fromSecsSinceEpoch(second).time();
+        auto two = [](char *p, int v) {
+            p[0] = char('0' + v / 10);
+            p[1] = char('0' + v % 10);
+        };
+        two(prefix, t.hour());
+        prefix[2] = ':';
+        two(prefix + 3, t.minute());
+        prefix[5] = ':';
+        two(prefix + 6, t.second());
+        prefix[8] = '.';
+        cachedSecond = second;
+    }
+
+    std::memcpy(out, prefix, sizeof(prefix));
+    out[9] = char('0' + ms / 100);
+    out[10] = char('0' + ms / 10 % 10);
+    out[11] = char('0' + ms % 10);
+    return out + kTimestampLength;
+}
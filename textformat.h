@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Allocation-free formatting for the log views. Each function writes into
+// 'out' and returns the end of what it wrote; callers provide room for
+// kMaxNumber (numbers) or kTimestampLength characters.
+constexpr size_t kMaxNumber = 32;
+constexpr size_t kTimestampLength = 12;     // hh:mm:ss.zzz
+
+char *formatInt(char *out, int64_t value);
+char *formatFixed(char *out, double value, int decimals);
+
+// Local time "hh:mm:ss.zzz". The "hh:mm:ss." part is converted once per
+// second and reused; within the second only the milliseconds are written.
+class TimestampFormatter
+{
+public:
+    char *format(char *out, int64_t msSinceEpoch);
+
+private:
+    int64_t cachedSecond = INT64_MIN;
+    char prefix[9];
+};
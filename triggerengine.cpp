@@ -0,0 +1,166 @@
+#include "triggerengine.h"
+
+#include <algorithm>
+#include <cmath>
+
+void TriggerEngine::configure(const TriggerSettings &settings)
+{
+    cfg = settings;
+    cfg.stepWindow = std::max<size_t>(cfg.stepWindow, 1);
+
+    history.clear();
+    stepValues.clear();
+    recentSum = olderSum = 0.0;
+    stepSinceResum = 0;
+    havePrevious = false;
+    collecting = false;
+    pending = TriggerCapture();
+    armed = cfg.type != TriggerSettings::Off;
+}
+
+void TriggerEngine::arm()
+{
+    armed = cfg.type != TriggerSettings::Off;
+}
+
+bool TriggerEngine::add(int64_t timestampUs, double value, bool motion, TriggerCapture &capture)
+{
+    if (cfg.type == TriggerSettings::Off)
+        return false;
+
+    double measured = 0.0;
+    Cause cause = evaluate(value, motion, measured);
+    bool fired = cause != NoCause;
+    bool completed = false;
+
+    if (collecting) {
+        pending.points.push_back({ timestampUs, value });
+        if (pending.points.size() == pending.triggerIndex + 1 + cfg.postSamples)
+            completed = true;
+    }
+    else if (fired && armed) {
+        armed = false;
+        collecting = true;
+
+        pending.sequence = nextSequence++;
+        pending.cause = describe(cause, measured);
+        pending.triggerUs = timestampUs;
+        pending.points.reserve(history.size() + 1 + cfg.postSamples);
+        for (size_t i = 0; i < history.size(); ++i)
+            pending.points.push_back(history[i]);
+        pending.triggerIndex = pending.points.size();
+        pending.points.push_back({ timestampUs, value });
+        completed = cfg.postSamples == 0;
+    }
+
+    if (completed) {
+        collecting = false;
+        capture = std::move(pending);
+        pending = TriggerCapture();
+        if (!cfg.singleShot)
+            armed = true;
+    }
+
+    if (cfg.preSamples) {
+        if (history.size() == cfg.preSamples)
+            history.pop_front();
+        history.push_back({ timestampUs, value });
+    }
+    return completed;
+}
+
+TriggerEngine::Cause TriggerEngine::evaluate(double value, bool motion, double &measured)
+{
+    bool rising = cfg.edge != TriggerSettings::Falling;
+    bool falling = cfg.edge != TriggerSettings::Rising;
+    Cause cause = NoCause;
+
+    switch (cfg.type) {
+    case TriggerSettings::Off:
+        break;
+
+    case TriggerSettings::Level:
+        if (havePrevious) {
+            if (rising && previous < cfg.threshold && value >= cfg.threshold)
+                cause = LevelRising;
+            else if (falling && previous > cfg.threshold && value <= cfg.threshold)
+                cause = LevelFalling;
+        }
+        break;
+
+    case TriggerSettings::Slope:
+        if (havePrevious) {
+            double rate = (value - previous) * cfg.sampleRateHz;
+            if ((rising && rate >= cfg.threshold) || (falling && -rate >= cfg.threshold)) {
+                cause = SlopeCause;
+                measured = rate;
+            }
+        }
+        break;
+
+    case TriggerSettings::Step: {
+        // Slide the 2N window: the oldest recent value becomes an older one
+        const size_t n = cfg.stepWindow;
+        stepValues.push_back(value);
+        recentSum += value;
+        if (stepValues.size() > n) {
+            double moved = stepValues[stepValues.size() - 1 - n];
+            recentSum -= moved;
+            olderSum += moved;
+        }
+        if (stepValues.size() > 2 * n) {
+            olderSum -= stepValues.front();
+            stepValues.pop_front();
+        }
+        // Re-add once per 2N samples so rounding cannot accumulate
+        if (++stepSinceResum >= 2 * n && stepValues.size() == 2 * n) {
+            stepSinceResum = 0;
+            olderSum = recentSum = 0.0;
+            for (size_t i = 0; i < n; ++i) {
+                olderSum += stepValues[i];
+                recentSum += stepValues[n + i];
+            }
+        }
+        if (stepValues.size() == 2 * n) {
+            double step = (recentSum - olderSum) / double(n);
+            if ((rising && step >= cfg.threshold) || (falling && -step >= cfg.threshold)) {
+                cause = StepCause;
+                measured = step;
+                // Restart so one step fires once
+                stepValues.clear();
+                recentSum = olderSum = 0.0;
+                stepSinceResum = 0;
+            }
+        }
+        break;
+    }
+
+    case TriggerSettings::Motion:
+        if (motion)
+            cause = MotionCause;
+        break;
+    }
+
+    previous = value;
+    havePrevious = true;
+    return cause;
+}
+
+QString TriggerEngine::describe(Cause cause, double measured) const
+{
+    switch (cause) {
+    case LevelRising:
+        return QString("level rising through %1").arg(cfg.threshold);
+    case LevelFalling:
+        return QString("level falling through %1").arg(cfg.threshold);
+    case SlopeCause:
+        return QString("slope %1 /s").arg(measured, 0, 'f', 3);
+    case StepCause:
+        return QString("step %1").arg(measured, 0, 'f', 3);
+    case MotionCause:
+        return "stable to motion";
+    case NoCause:
+        break;
+    }
+    return QString();
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <QMetaType>
+#include <QString>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "ringdeque.h"
+
+struct TriggerSettings
+{
+    enum Type : uint8_t
+    {
+        Off,
+        Level,      // value crosses 'threshold'
+        Slope,      // sample-to-sample rate exceeds 'threshold' per second
+        Step,       // mean of the last N samples moved by 'threshold' from the N before
+        Motion      // stability detector leaves the stable state
+    };
+    enum Edge : uint8_t { Rising, Falling, Either };
+
+    Type type = Off;
+    Edge edge = Rising;
+    double threshold = 0.0;
+    size_t stepWindow = 4;
+    size_t preSamples = 100;
+    size_t postSamples = 100;
+    bool singleShot = false;
+    double sampleRateHz = 10.0;
+};
+
+struct TriggerCapture
+{
+    struct Point
+    {
+        int64_t timestampUs;
+        double value;
+    };
+
+    uint32_t sequence = 0;
+    QString cause;
+    int64_t triggerUs = 0;
+    size_t triggerIndex = 0;    // position of the trigger sample in 'points'
+    std::vector<Point> points;
+};
+
+Q_DECLARE_METATYPE(TriggerCapture)
+
+// Oscilloscope style trigger on the filtered weight. The last preSamples
+// values are kept in a ring; when the trigger condition fires they are
+// frozen together with the next postSamples values into a capture. Further
+// triggers are ignored until the capture is complete, single-shot mode
+// then stays disarmed until armed again.
+class TriggerEngine
+{
+public:
+    void configure(const TriggerSettings &settings);
+    const TriggerSettings &settings() const { return cfg; }
+
+    // Rate of the values fed in; keeps the arm state and a capture in progress
+    void setSampleRate(double rateHz) { cfg.sampleRateHz = rateHz; }
+
+    void arm();
+    bool isArmed() const { return armed; }
+
+    // 'motion' is true for the sample on which the stability detector
+    // reported motion. Returns true and fills 'capture' when one completes.
+    bool add(int64_t timestampUs, double value, bool motion, TriggerCapture &capture);
+
+private:
+    enum Cause : uint8_t { NoCause, LevelRising, LevelFalling, SlopeCause, StepCause, MotionCause };
+
+    // Per sample and allocation free; the text is only built for a capture
+    Cause evaluate(double value, bool motion, double &measured);
+    QString describe(Cause cause, double measured) const;
+
+    TriggerSettings cfg;
+    bool armed = false;
+
+    RingDeque<TriggerCapture::Point> history;
+    bool havePrevious = false;
+    double previous = 0.0;
+
+    // Step trigger: the last 2N values and the sums of both halves
+    RingDeque<double> stepValues;
+    double recentSum = 0.0;
+    double olderSum = 0.0;
+    size_t stepSinceResum = 0;
+
+    bool collecting = false;
+    TriggerCapture pending;
+    uint32_t nextSequence = 1;
+};